@@ -0,0 +1,38 @@
+#pragma once
+
+#include <eosio/asset.hpp>
+#include <eosio/symbol.hpp>
+
+/**
+* Digital Handshake shared configuration
+*
+* @details Compile-time constants shared by the dhstoken, dhsservice and dhsescrow contracts. Every amount is expressed
+* in base units of the DHS token (e.g. 1.0000 DHS is 10000), so the contracts can compare raw `asset::amount` values
+* without any runtime conversion.
+* @{
+*/
+namespace dhs
+{
+    // Compute 10^exponent at compile time.
+    constexpr int64_t pow10(uint8_t exponent)
+    {
+        return exponent == 0 ? 1 : 10 * pow10(exponent - 1);
+    }
+
+    constexpr uint8_t token_precision = 4;                        // The number of decimals of the DHS token.
+    constexpr eosio::symbol token_symbol{"DHS", token_precision}; // The DHS token symbol.
+    constexpr int64_t token_unit = pow10(token_precision);        // The amount of base units in 1 DHS.
+    constexpr int64_t stake_amount = 30 * token_unit;             // The fixed stake necessary for every digital handshake (30.0000 DHS).
+
+    static_assert(token_symbol.precision() == token_precision, "dhsconfig: INVALID TOKEN PRECISION");
+    static_assert(stake_amount > 0 && stake_amount < eosio::asset::max_amount, "dhsconfig: INVALID STAKE AMOUNT");
+
+    // Build a DHS asset from an amount in base units (amounts are already validated by the callers).
+    inline eosio::asset make_asset(int64_t amount)
+    {
+        eosio::asset value;
+        value.amount = amount;
+        value.symbol = token_symbol;
+        return value;
+    }
+} // namespace dhs
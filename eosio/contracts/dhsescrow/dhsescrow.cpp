@@ -1,39 +1,168 @@
 #include "dhsescrow.hpp"
 
-void dhsescrow::locktokens(eosio::name dhsservice, eosio::name user, eosio::asset quantity)
+void dhsescrow::migratelocks(uint32_t max_rows)
 {
-    // Ensure the dhsservice contract authorizes this action.
+    // Verify input data (no authorization required, anyone can pay for the migration).
+    check(max_rows > 0, "migratelocks: INVALID MAX ROWS");
+
+    // Verify if there is any legacy balance left.
+    legacy_locked_table legacy_locked(get_self(), get_self().value);
+    check(legacy_locked.begin() != legacy_locked.end(), "migratelocks: NO LEGACY LOCKS");
+
+    // The handshakes are read with the current dhsservice layout.
+    service_hash_migration_singleton service_migration("dhsservice"_n, "dhsservice"_n.value);
+    check(service_migration.exists() && service_migration.get().step == service_migration_done, "migratelocks: SERVICE MIGRATION PENDING");
+
+    lock_migration migration = _lock_migration.get_or_default();
+
+    if (migration.step == MIGRATE_HANDSHAKE_LOCKS)
+    {
+        service_handshakes_table handshakes("dhsservice"_n, "dhsservice"_n.value);
+        auto itr = handshakes.lower_bound(migration.cursor);
+
+        for (; itr != handshakes.end() && max_rows > 0; itr++, max_rows--)
+        {
+            migration.cursor = uint64_t(itr->request_id) + 1;
+
+            // Only the handshakes from LOCK to VOTING status can have locked tokens (the ledger rows are already tracked).
+            if (itr->status < service_lock_status || itr->status > service_voting_status || _ledger.find(itr->request_id) != _ledger.end())
+                continue;
+
+            // Move the tokens locked and not unlocked yet by the dealer (price plus stake) and by the bidder (stake).
+            int64_t dealer_amount = itr->lock_by_dealer && !itr->unlock_for_expiration_by_dealer
+                                        ? take_legacy_funds(legacy_locked, itr->dealer, itr->price.amount + dhs::stake_amount)
+                                        : 0;
+            int64_t bidder_amount = itr->lock_by_bidder && !itr->unlock_for_expiration_by_bidder
+                                        ? take_legacy_funds(legacy_locked, itr->bidder, dhs::stake_amount)
+                                        : 0;
+
+            if (dealer_amount == 0 && bidder_amount == 0)
+                continue;
+
+            _ledger.emplace(get_self(), [&](auto &row) {
+                row.dhs_id = itr->request_id;
+                row.dealer = itr->dealer;
+                row.bidder = itr->bidder;
+                row.dealer_funds = dhs::make_asset(dealer_amount);
+                row.bidder_funds = dhs::make_asset(bidder_amount);
+            });
+
+            update_stats(dealer_amount + bidder_amount, 1);
+        }
+
+        if (itr == handshakes.end())
+            migration.step = REFUND_LEFTOVERS;
+    }
+
+    if (migration.step == REFUND_LEFTOVERS)
+    {
+        // Send back the legacy balances left, with a single inline transfer (the settled balances are left with zero funds).
+        vector<pair<eosio::name, eosio::asset>> refunds;
+
+        for (auto itr = legacy_locked.begin(); itr != legacy_locked.end() && max_rows > 0; max_rows--)
+        {
+            if (itr->funds.amount > 0)
+                refunds.emplace_back(itr->user, itr->funds);
+
+            itr = legacy_locked.erase(itr);
+        }
+
+        if (!refunds.empty())
+        {
+            action{
+                permission_level{get_self(), "active"_n},
+                "dhstoken"_n,
+                "transfermany"_n,
+                std::make_tuple(get_self(), refunds, std::string("Unlocked tokens"))}
+                .send();
+        }
+    }
+
+    // The progress is dropped once the migration is done.
+    if (legacy_locked.begin() == legacy_locked.end())
+        _lock_migration.remove();
+    else
+        _lock_migration.set(migration, get_self());
+}
+
+void dhsescrow::notifylock(eosio::name from, eosio::name to, eosio::asset quantity, std::string memo)
+{
+    // Track only the tokens forwarded by the dhsservice contract.
     // nb. no other checks are required because they are in the dhsservice contract.
-    require_auth(dhsservice);
+    if (to != get_self() || from != "dhsservice"_n)
+    {
+        return;
+    }
+
+    // Read the user, the handshake and the user role from the memo.
+    eosio::name user;
+    int32_t dhs_id;
+    bool is_dealer;
+
+    check(parse_lock_memo(memo, user, dhs_id, is_dealer), "notifylock: INVALID MEMO");
+
+    // Verify that the balances locked by the previous contract version have been migrated.
+    require_migrated("notifylock");
 
-    // Track the amount of locked DHS tokens for from account.
-    auto existing_balance = _locked.find(user.value);
+    // Track the amount of locked DHS tokens for the handshake.
+    auto existing_lock = _ledger.find(dhs_id);
 
-    if (existing_balance != _locked.end())
-        _locked.modify(existing_balance, get_self(), [&](auto &row) {
-            row.funds += quantity;
+    if (existing_lock == _ledger.end())
+    {
+        _ledger.emplace(get_self(), [&](auto &row) {
+            row.dhs_id = dhs_id;
+            row.dealer = is_dealer ? user : eosio::name();
+            row.bidder = is_dealer ? eosio::name() : user;
+            row.dealer_funds = is_dealer ? quantity : dhs::make_asset(0);
+            row.bidder_funds = is_dealer ? dhs::make_asset(0) : quantity;
         });
+
+        update_stats(quantity.amount, 1);
+    }
     else
-        _locked.emplace(get_self(), [&](auto &row) {
-            row.user = user;
-            row.funds = quantity;
+    {
+        // Verify that the user has not already locked the tokens for the handshake.
+        check(is_dealer ? existing_lock->dealer_funds.amount == 0 : existing_lock->bidder_funds.amount == 0, "notifylock: ALREADY LOCKED TOKENS");
+
+        _ledger.modify(existing_lock, get_self(), [&](auto &row) {
+            if (is_dealer)
+            {
+                row.dealer = user;
+                row.dealer_funds = quantity;
+            }
+            else
+            {
+                row.bidder = user;
+                row.bidder_funds = quantity;
+            }
         });
+
+        update_stats(quantity.amount, 0);
+    }
 }
 
-void dhsescrow::unlocktokens(eosio::name dhsservice, eosio::name user, eosio::asset quantity)
+void dhsescrow::unlocktokens(eosio::name dhsservice, int32_t dhs_id, eosio::name user, eosio::asset quantity)
 {
     // Ensure the dhsservice contract authorizes this action.
     // nb. no other checks are required because they are in the dhsservice contract.
+    check(dhsservice == "dhsservice"_n, "unlocktokens: NOT DHSSERVICE CONTRACT");
     require_auth(dhsservice);
 
-    // Track the amount of locked DHS tokens for user account.
-    auto existing_balance = _locked.find(user.value);
+    // Verify that the balances locked by the previous contract version have been migrated.
+    require_migrated("unlocktokens");
+
+    // Verify handshake lock.
+    auto existing_lock = _ledger.find(dhs_id);
+
+    check(existing_lock != _ledger.end(), "unlocktokens: NOT LOCKED TOKENS FOR HANDSHAKE");
+    check(existing_lock->dealer == user || existing_lock->bidder == user, "unlocktokens: USER NOT HANDSHAKE PARTICIPANT");
 
-    // Verify user lock balance.
-    check(existing_balance != _locked.end(), "unlocktokens: NOT LOCKED TOKENS FOR USER");
-    check(existing_balance->funds.amount / 10000 >= quantity.amount / 10000, "unlocktokens: OVERDRAWN LOCK AMOUNT");
+    bool is_dealer = existing_lock->dealer == user;
 
-    // Send tokens to dhsservice.
+    // Verify the user lock amount.
+    check(quantity == (is_dealer ? existing_lock->dealer_funds : existing_lock->bidder_funds), "unlocktokens: NOT CORRECT LOCK AMOUNT");
+
+    // Send tokens back to the user.
     action{
         permission_level{get_self(), "active"_n},
         "dhstoken"_n,
@@ -41,145 +170,185 @@ void dhsescrow::unlocktokens(eosio::name dhsservice, eosio::name user, eosio::as
         std::make_tuple(get_self(), user, quantity, std::string("Unlocked tokens"))}
         .send();
 
-    // Update existing lock balance.
-    _locked.modify(existing_balance, get_self(), [&](auto &row) {
-        row.funds -= quantity;
-    });
+    if ((is_dealer ? existing_lock->bidder_funds : existing_lock->dealer_funds).amount == 0)
+    {
+        // Both users have unlocked the tokens.
+        _ledger.erase(existing_lock);
+        update_stats(-quantity.amount, -1);
+    }
+    else
+    {
+        // Update existing handshake lock.
+        _ledger.modify(existing_lock, get_self(), [&](auto &row) {
+            (is_dealer ? row.dealer_funds : row.bidder_funds).amount = 0;
+        });
+
+        update_stats(-quantity.amount, 0);
+    }
 }
 
-void dhsescrow::accepted(eosio::name dhsservice, eosio::name dealer, eosio::name bidder, eosio::asset price)
+void dhsescrow::accepted(eosio::name dhsservice, int32_t dhs_id, eosio::asset price)
 {
     // Ensure the dhsservice contract authorizes this action.
     // nb. no other checks are required because they are in the dhsservice contract.
+    check(dhsservice == "dhsservice"_n, "accepted: NOT DHSSERVICE CONTRACT");
     require_auth(dhsservice);
 
-    // Track the amount of locked DHS tokens for dealer.
-    auto dealer_balance = _locked.find(dealer.value);
-
-    // Verify dealer lock balance.
-    check(dealer_balance != _locked.end(), "accepted: NOT LOCKED TOKENS FOR DEALER");
-    check(dealer_balance->funds.amount / 10000 >= price.amount / 10000 + fixed_stake.amount, "accepted: OVERDRAWN LOCK AMOUNT FOR DEALER");
+    // Verify that the balances locked by the previous contract version have been migrated.
+    require_migrated("accepted");
 
-    // Track the amount of locked DHS tokens for bidder.
-    auto bidder_balance = _locked.find(bidder.value);
+    // Verify handshake lock.
+    auto existing_lock = _ledger.find(dhs_id);
 
-    // Verify bidder lock balance.
-    check(bidder_balance != _locked.end(), "accepted: NOT LOCKED TOKENS FOR BIDDER");
-    check(bidder_balance->funds.amount / 10000 >= fixed_stake.amount, "accepted: OVERDRAWN LOCK AMOUNT FOR BIDDER");
+    check(existing_lock != _ledger.end(), "accepted: NOT LOCKED TOKENS FOR HANDSHAKE");
+    check(existing_lock->dealer_funds.amount == price.amount + dhs::stake_amount, "accepted: NOT CORRECT LOCK AMOUNT FOR DEALER");
+    check(existing_lock->bidder_funds.amount == dhs::stake_amount, "accepted: NOT CORRECT LOCK AMOUNT FOR BIDDER");
 
-    // Update existing lock dealer balance.
-    _locked.modify(dealer_balance, get_self(), [&](auto &row) {
-        row.funds -= price + (fixed_stake * 10000);
-    });
-
-    // Update existing lock bidder balance.
-    _locked.modify(bidder_balance, get_self(), [&](auto &row) {
-        row.funds -= (fixed_stake * 10000);
-    });
-
-    // Inline transfer to dealer.
+    // Inline transfer to dealer (stake) and bidder (stake plus price).
     action{
         permission_level{get_self(), "active"_n},
         "dhstoken"_n,
-        "transfer"_n,
-        std::make_tuple(get_self(), dealer, (fixed_stake * 10000), std::string("Handshake accepted"))}
+        "transfermany"_n,
+        std::make_tuple(get_self(),
+                        vector<pair<eosio::name, eosio::asset>>{{existing_lock->dealer, dhs::make_asset(dhs::stake_amount)},
+                                                                {existing_lock->bidder, dhs::make_asset(dhs::stake_amount + price.amount)}},
+                        std::string("Handshake accepted"))}
         .send();
 
-    // Inline transfer to bidder.
-    action{
-        permission_level{get_self(), "active"_n},
-        "dhstoken"_n,
-        "transfer"_n,
-        std::make_tuple(get_self(), bidder, (fixed_stake * 10000) + price, std::string("Handshake accepted"))}
-        .send();
+    // Settle the handshake lock.
+    update_stats(-(existing_lock->dealer_funds.amount + existing_lock->bidder_funds.amount), -1);
+    _ledger.erase(existing_lock);
 }
 
-void dhsescrow::resolved(eosio::name dhsservice, eosio::name dealer, eosio::name bidder, eosio::asset price, vector<eosio::name> jurors, uint8_t winner)
+void dhsescrow::resolved(eosio::name dhsservice, int32_t dhs_id, eosio::asset price, vector<eosio::name> jurors, uint8_t winner)
 {
     // Ensure the dhsservice contract authorizes this action.
     // nb. no other checks are required because they are in the dhsservice contract.
+    check(dhsservice == "dhsservice"_n, "resolved: NOT DHSSERVICE CONTRACT");
     require_auth(dhsservice);
 
-    // Track the amount of locked DHS tokens for dealer and bidder.
-    auto dealer_balance = _locked.find(dealer.value);
-    auto bidder_balance = _locked.find(bidder.value);
+    // Verify that the balances locked by the previous contract version have been migrated.
+    require_migrated("resolved");
 
-    // Verify dealer lock balance.
-    check(dealer_balance != _locked.end(), "resolved: NOT LOCKED TOKENS FOR DEALER");
-    check(dealer_balance->funds.amount / 10000 >= fixed_stake.amount, "resolved: OVERDRAWN LOCK AMOUNT FOR DEALER");
+    // Verify handshake lock.
+    auto existing_lock = _ledger.find(dhs_id);
 
-    // Verify bidder lock balance.
-    check(bidder_balance != _locked.end(), "resolved: NOT LOCKED TOKENS FOR BIDDER");
-    check(bidder_balance->funds.amount / 10000 >= fixed_stake.amount, "resolved: OVERDRAWN LOCK AMOUNT FOR BIDDER");
+    check(existing_lock != _ledger.end(), "resolved: NOT LOCKED TOKENS FOR HANDSHAKE");
+    check(existing_lock->dealer_funds.amount == price.amount + dhs::stake_amount, "resolved: NOT CORRECT LOCK AMOUNT FOR DEALER");
+    check(existing_lock->bidder_funds.amount == dhs::stake_amount, "resolved: NOT CORRECT LOCK AMOUNT FOR BIDDER");
 
     // Verify other input data.
     check(winner == DEALER || winner == BIDDER, "resolved: INVALID WINNER");
+    check(jurors.size() > 0, "resolved: NO JURORS");
+
+    // Collect every payout and send them with a single inline transfer.
+    vector<pair<eosio::name, eosio::asset>> transfers;
+    transfers.reserve(jurors.size() + 2);
 
     if (winner == DEALER)
     {
-        // Inline transfer dealer.
-        action{
-            permission_level{get_self(), "active"_n},
-            "dhstoken"_n,
-            "transfer"_n,
-            std::make_tuple(get_self(), dealer, price + (fixed_stake * 10000), std::string("Resolved"))}
-            .send();
+        // Dealer gets back price and stake.
+        transfers.emplace_back(existing_lock->dealer, dhs::make_asset(price.amount + dhs::stake_amount));
     }
 
     if (winner == BIDDER)
     {
-        // Inline transfer bidder.
-        action{
-            permission_level{get_self(), "active"_n},
-            "dhstoken"_n,
-            "transfer"_n,
-            std::make_tuple(get_self(), bidder, (fixed_stake * 10000), std::string("Resolved"))}
-            .send();
-
-        // Inline transfer dealer.
-        action{
-            permission_level{get_self(), "active"_n},
-            "dhstoken"_n,
-            "transfer"_n,
-            std::make_tuple(get_self(), dealer, price, std::string("Resolved"))}
-            .send();
+        // Bidder gets back the stake and the dealer the price.
+        transfers.emplace_back(existing_lock->bidder, dhs::make_asset(dhs::stake_amount));
+        transfers.emplace_back(existing_lock->dealer, price);
     }
 
-    eosio::name juror1 = jurors.at(0);
-    eosio::name juror2 = jurors.at(1);
-    eosio::name juror3 = jurors.at(2);
+    // Split the loser stake between the jurors (the remainder of the division goes to the first juror).
+    int64_t juror_share = dhs::stake_amount / int64_t(jurors.size());
+    int64_t remainder = dhs::stake_amount - juror_share * int64_t(jurors.size());
 
-    // Inline transfer juror1.
-    action{
-        permission_level{get_self(), "active"_n},
-        "dhstoken"_n,
-        "transfer"_n,
-        std::make_tuple(get_self(), juror1, ((fixed_stake / 3) * 10000), std::string("Resolved"))}
-        .send();
+    for (size_t i = 0; i < jurors.size(); i++)
+    {
+        transfers.emplace_back(jurors[i], dhs::make_asset(i == 0 ? juror_share + remainder : juror_share));
+    }
 
-    // Inline transfer juror2.
+    // Inline transfer to winner and jurors.
     action{
         permission_level{get_self(), "active"_n},
         "dhstoken"_n,
-        "transfer"_n,
-        std::make_tuple(get_self(), juror2, ((fixed_stake / 3) * 10000), std::string("Resolved"))}
+        "transfermany"_n,
+        std::make_tuple(get_self(), transfers, std::string("Resolved"))}
         .send();
 
-    // Inline transfer juror3.
-    action{
-        permission_level{get_self(), "active"_n},
-        "dhstoken"_n,
-        "transfer"_n,
-        std::make_tuple(get_self(), juror3, ((fixed_stake / 3) * 10000), std::string("Resolved"))}
-        .send();
+    // Settle the handshake lock.
+    update_stats(-(existing_lock->dealer_funds.amount + existing_lock->bidder_funds.amount), -1);
+    _ledger.erase(existing_lock);
+}
 
-    // Update existing lock dealer balance.
-    _locked.modify(dealer_balance, get_self(), [&](auto &row) {
-        row.funds -= price + (fixed_stake * 10000);
-    });
+/** HELPERS **/
+
+void dhsescrow::update_stats(int64_t locked_amount, int64_t locks)
+{
+    escrow_stats stats = _stats.get_or_default();
+
+    stats.total_locked.amount += locked_amount;
+    stats.open_locks += locks;
 
-    // Update existing lock bidder balance.
-    _locked.modify(bidder_balance, get_self(), [&](auto &row) {
-        row.funds -= (fixed_stake * 10000);
+    _stats.set(stats, get_self());
+}
+
+void dhsescrow::require_migrated(const char *action_name)
+{
+    legacy_locked_table legacy_locked(get_self(), get_self().value);
+
+    if (legacy_locked.begin() != legacy_locked.end())
+        check(false, std::string(action_name) + ": MIGRATION PENDING");
+}
+
+int64_t dhsescrow::take_legacy_funds(legacy_locked_table &legacy_locked, eosio::name user, int64_t amount)
+{
+    auto balance = legacy_locked.find(user.value);
+
+    if (balance == legacy_locked.end())
+        return 0;
+
+    int64_t taken = std::min(amount, balance->funds.amount);
+
+    legacy_locked.modify(balance, get_self(), [&](auto &row) {
+        row.funds.amount -= taken;
     });
+
+    return taken;
+}
+
+bool dhsescrow::parse_lock_memo(const std::string &memo, eosio::name &user, int32_t &dhs_id, bool &is_dealer)
+{
+    // User name.
+    auto user_end = memo.find(':');
+
+    if (user_end == std::string::npos || user_end == 0 || user_end > 12)
+        return false;
+
+    // Handshake identifier (at most 9 digits, so the value always fits an int32_t).
+    auto id_end = memo.find(':', user_end + 1);
+
+    if (id_end == std::string::npos || id_end == user_end + 1 || id_end - user_end - 1 > 9)
+        return false;
+
+    int32_t value = 0;
+
+    for (size_t i = user_end + 1; i < id_end; i++)
+    {
+        if (memo[i] < '0' || memo[i] > '9')
+            return false;
+
+        value = value * 10 + (memo[i] - '0');
+    }
+
+    // User role.
+    std::string_view role(memo.data() + id_end + 1, memo.length() - id_end - 1);
+
+    if (role != "dealer" && role != "bidder")
+        return false;
+
+    user = eosio::name(std::string_view(memo.data(), user_end));
+    dhs_id = value;
+    is_dealer = role == "dealer";
+
+    return true;
 }
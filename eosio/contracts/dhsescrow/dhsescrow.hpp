@@ -2,6 +2,9 @@
 #include <eosio/print.hpp>
 #include <eosio/asset.hpp>
 #include <eosio/system.hpp>
+#include <eosio/crypto.hpp>
+#include <eosio/singleton.hpp>
+#include "../common/dhsconfig.hpp"
 
 using namespace std;
 using namespace eosio;
@@ -17,9 +20,6 @@ using namespace eosio;
 class [[eosio::contract]] dhsescrow : public eosio::contract
 {
 private:
-    const symbol dhs_symbol;        // The DHS token symbol.
-    const eosio::asset fixed_stake; // The fixed price for the amount of stake necessary for every digital handshake.
-
     // List of values for the different possible role for a dispute winner.
     enum winner_role : uint8_t
     {
@@ -27,8 +27,52 @@ private:
         BIDDER = 1
     };
 
-    // Keep track of the amounts of DHS tokens deposited by users for handshakes.
-    struct [[eosio::table]] balance
+    // Keep track of the amounts of DHS tokens deposited by the dealer and bidder of a handshake.
+    struct [[eosio::table]] handshake_lock
+    {
+        int32_t dhs_id;            // Unique identifier of the digital handshake.
+        eosio::name dealer;        // The dealer username.
+        eosio::name bidder;        // The bidder username.
+        eosio::asset dealer_funds; // The tokens locked by the dealer (price plus stake).
+        eosio::asset bidder_funds; // The tokens locked by the bidder (stake).
+
+        auto primary_key() const { return dhs_id; }
+        uint128_t dealer_secondary() const { return (uint128_t(dealer.value) << 64) | uint32_t(dhs_id); }
+        uint128_t bidder_secondary() const { return (uint128_t(bidder.value) << 64) | uint32_t(dhs_id); }
+    };
+
+    typedef eosio::multi_index<"ledger"_n, handshake_lock,
+                               eosio::indexed_by<"bydealer"_n, eosio::const_mem_fun<handshake_lock, uint128_t, &handshake_lock::dealer_secondary>>,
+                               eosio::indexed_by<"bybidder"_n, eosio::const_mem_fun<handshake_lock, uint128_t, &handshake_lock::bidder_secondary>>>
+        ledger_table;
+
+    // Escrow statistics for dashboards, updated incrementally by the actions.
+    struct [[eosio::table]] escrow_stats
+    {
+        eosio::asset total_locked = dhs::make_asset(0); // The DHS tokens locked for all the handshakes.
+        uint64_t open_locks = 0;                        // The number of handshakes with a ledger row.
+    };
+
+    typedef eosio::singleton<"stats"_n, escrow_stats> escrow_stats_singleton;
+
+    // List of the steps of the migration of the balances locked by the previous contract version.
+    enum lock_migration_step : uint8_t
+    {
+        MIGRATE_HANDSHAKE_LOCKS = 0, // The tokens locked for the dhsservice handshakes move from the legacy balances to the ledger.
+        REFUND_LEFTOVERS = 1         // The legacy balances left (backing no handshake) are sent back to their users.
+    };
+
+    // Progress of the migration of the balances locked by the previous contract version.
+    struct [[eosio::table]] lock_migration
+    {
+        uint8_t step = MIGRATE_HANDSHAKE_LOCKS; // The migration step.
+        uint64_t cursor = 0;                    // The handshake identifier where the migration resumes.
+    };
+
+    typedef eosio::singleton<"lockmigr"_n, lock_migration> lock_migration_singleton;
+
+    // Row layout written by the previous contract version, the tokens locked by a user for all its handshakes (read only by `migratelocks`).
+    struct legacy_balance
     {
         eosio::name user;
         eosio::asset funds;
@@ -36,64 +80,141 @@ private:
         uint64_t primary_key() const { return user.value; }
     };
 
-    typedef eosio::multi_index<"locked"_n, balance> locked_balance;
+    typedef eosio::multi_index<"locked"_n, legacy_balance> legacy_locked_table;
+
+    // Row layouts of the dhsservice contract, field by field (read only by `migratelocks`).
+    struct service_handshake
+    {
+        int32_t request_id;
+        eosio::name dealer;
+        eosio::name bidder;
+        eosio::asset price;
+        uint32_t deadline;
+        eosio::checksum256 contractual_terms_hash;
+        uint8_t status;
+        uint32_t rounds;
+        bool accepted_by_dealer;
+        bool accepted_by_bidder;
+        bool lock_by_dealer;
+        bool lock_by_bidder;
+        bool unlock_for_expiration_by_dealer;
+        bool unlock_for_expiration_by_bidder;
+
+        auto primary_key() const { return request_id; }
+    };
+
+    typedef eosio::multi_index<"handshakes"_n, service_handshake> service_handshakes_table;
+
+    struct service_hash_migration
+    {
+        uint8_t step;
+        uint64_t cursor;
+        uint32_t child;
+    };
+
+    typedef eosio::singleton<"hashmigr"_n, service_hash_migration> service_hash_migration_singleton;
+
+    static constexpr uint8_t service_migration_done = 5; // The dhsservice hash migration step once every table is migrated.
+    static constexpr uint8_t service_lock_status = 1;    // The first dhsservice handshake status with locked tokens (LOCK).
+    static constexpr uint8_t service_voting_status = 5;  // The last dhsservice handshake status with locked tokens (VOTING).
 
-    locked_balance _locked;
+    ledger_table _ledger;
+    escrow_stats_singleton _stats;
+    lock_migration_singleton _lock_migration;
+
+    // Helper to add (or remove, when negative) locked tokens and handshakes to the escrow statistics.
+    void update_stats(int64_t locked_amount, int64_t locks);
+
+    // Helper to check, at the top of every action moving tokens, that no balance locked by the previous contract version is left.
+    void require_migrated(const char *action_name);
+
+    // Helper to move up to `amount` tokens out of the legacy balance of a user. Returns the amount moved.
+    int64_t take_legacy_funds(legacy_locked_table &legacy_locked, eosio::name user, int64_t amount);
+
+    // Helper to parse the "<user>:<handshake identifier>:<dealer|bidder>" memo of a forwarded stake without allocations.
+    static bool parse_lock_memo(const std::string &memo, eosio::name &user, int32_t &dhs_id, bool &is_dealer);
 
 public:
     using contract::contract;
 
     dhsescrow(eosio::name receiver, eosio::name code, datastream<const char *> ds) : contract(receiver, code, ds),
-                                                                                     _locked(receiver, receiver.value), // Init locked table with a global scope.
-                                                                                     dhs_symbol("DHS", 4),
-                                                                                     fixed_stake(30.0000, symbol("DHS", 4))
+                                                                                     _ledger(receiver, receiver.value),        // Init ledger table with a global scope.
+                                                                                     _stats(receiver, receiver.value),         // Init escrow statistics with a global scope.
+                                                                                     _lock_migration(receiver, receiver.value) // Init locks migration progress with a global scope.
     {
     }
 
     /**
-     * Lock tokens action.
+     * Migrate locks action.
+     *
+     * @details Migration that moves the tokens of the previous contract version, locked per user in the `locked` table, into the ledger
+     * rows of the handshakes. Every dhsservice handshake from LOCK to VOTING status gets a ledger row with the tokens its dealer (price plus
+     * stake) and bidder (stake) have locked and not unlocked yet, taken from their legacy balances and counted in the escrow statistics.
+     * The legacy balances left afterwards back no handshake and are sent back to their users. The other escrow actions fail until the
+     * `locked` table is empty, so run the `migratehash` action of the dhsservice contract first, then this action.
+     * No authorization required (no one owns the contract), the result depends only on the stored rows.
+     * @param max_rows - the maximum number of handshakes or legacy balances to visit.
+     *
+     * @pre Max rows must be greater than zero,
+     * @pre No legacy locked balance left,
+     * @pre Hash migration of the dhsservice contract not done.
+     *
+     * The action can be repeated until the `locked` table is empty. A legacy balance short of the amount of a handshake (the previous version
+     * compared whole tokens only) moves what is left.
+     */
+    [[eosio::action]] void migratelocks(uint32_t max_rows);
+
+    /**
+     * Listen for lock tokens action.
      * 
-     * @details Lock a certain `amount` of tokens on the behalf of the `user` from the `dhsservice` contract.
-     * @param dhsservice - the sender dhsservice contract account,
-     * @param user - the user who needs to lock tokens,
+     * @details Listen on `dhstoken::transfer` action calls where the `dhsservice` contract forwards to the escrow the tokens locked by a user for an handshake.
+     * @param from - the sender dhsservice contract account,
+     * @param to - the dhsescrow contract account,
      * @param quantity - the amount of token to lock,
+     * @param memo - the user who locks the tokens, the handshake identifier and the user role (e.g. "alice:1:dealer").
+     * 
+     * @pre Memo is not in the "<user>:<handshake identifier>:<dealer|bidder>" format,
+     * @pre Balances locked by the previous contract version not migrated yet (see `migratelocks`),
+     * @pre User has already locked tokens for the handshake,
      * 
-     * If validation is successful, the `quantity` of tokens to be locked will be summed in the row corresponding to the `from` account.
+     * If the transfer goes from the dhsservice contract to the escrow, the `quantity` of tokens will be stored in the ledger row of the handshake.
      */
-    [[eosio::action]] void locktokens(eosio::name dhsservice, eosio::name user, eosio::asset quantity);
+    [[eosio::on_notify("dhstoken::transfer")]] void notifylock(eosio::name from, eosio::name to, eosio::asset quantity, std::string memo);
 
     /**
      * Unlock tokens action.
      * 
-     * @details Unlock a certain `amount` of tokens on the behalf of the `user` and sends them back.
+     * @details Unlock the tokens locked by the `user` for an expired handshake and sends them back.
      * @param dhsservice - the dhsservice contract account,
+     * @param dhs_id - the identifier of the digital handshake,
      * @param user - the user who needs to unlock tokens,
      * @param quantity - the amount of token to unlock,
      * 
-     * @pre User has not any DHS token locked,
-     * @pre User has not a locked balance equal or greater than quantity,
+     * @pre Balances locked by the previous contract version not migrated yet (see `migratelocks`),
+     * @pre Handshake has not any DHS token locked,
+     * @pre User is not the dealer/bidder of the handshake,
+     * @pre Quantity is not equal to the tokens locked by the user for the handshake,
      * 
-     * If validation is successful, the `quantity` of tokens to be unlocked will be transferred back to the user.
+     * If validation is successful, the `quantity` of tokens will be transferred back to the user. The ledger row is erased once both users have unlocked the tokens.
      */
-    [[eosio::action]] void unlocktokens(eosio::name dhsservice, eosio::name user, eosio::asset quantity);
+    [[eosio::action]] void unlocktokens(eosio::name dhsservice, int32_t dhs_id, eosio::name user, eosio::asset quantity);
 
     /**
      * Accepted action.
      * 
      * @details Unlock the total amount of tokens that must be redistributed by `dhsservice` when the `dealer` has accepted and finalized the handshake.
      * @param dhsservice - the sender dhsservice contract account,
-     * @param dealer - the dealer who accepts the handshake,
-     * @param bidder - the bidder who participate in the handshake,
+     * @param dhs_id - the identifier of the digital handshake,
      * @param price - the price of the handshake,
      * 
-     * @pre Dealer has not any DHS token locked,
-     * @pre Dealer has not a locked balance equal or greater than quantity,
-     * @pre Bidder has not any DHS token locked,
-     * @pre Bidder has not a locked balance equal or greater than quantity,
+     * @pre Balances locked by the previous contract version not migrated yet (see `migratelocks`),
+     * @pre Handshake has not any DHS token locked,
+     * @pre Dealer has not locked exactly the price plus the stake,
+     * @pre Bidder has not locked exactly the stake,
      * 
-     * If validation is successful the right amounts of tokens will be subtracted from the locked balances of dealer and bidder.
+     * If validation is successful the locked tokens are sent to the dealer (stake) and bidder (stake plus price) and the ledger row is erased.
      */
-    [[eosio::action]] void accepted(eosio::name dhsservice, eosio::name dealer, eosio::name bidder, eosio::asset price);
+    [[eosio::action]] void accepted(eosio::name dhsservice, int32_t dhs_id, eosio::asset price);
 
     /**
      * Resolved action.
@@ -101,20 +222,20 @@ public:
      * @details Unlock the amount of tokens that must be redistributed by `dhsservice` when all the jurors has expressed their vote preference
      * for a disputing handshake. 
      * @param dhsservice - the sender dhsservice contract account,
-     * @param dealer - the dealer who accepts the handshake,
-     * @param bidder - the bidder who participate in the handshake,
+     * @param dhs_id - the identifier of the digital handshake,
      * @param price - the price of the handshake,
      * @param jurors - the vector containing the names of the jurors to be remunerated,
      * @param winner - a value that indicates who the winner is (dealer/bidder).
      * 
-     * @pre Dealer has not any DHS token locked,
-     * @pre Dealer has not a locked balance equal or greater than quantity,
-     * @pre Bidder has not any DHS token locked,
-     * @pre Bidder has not a locked balance equal or greater than quantity,
-     * @pre Winner must be dealer or bidder.
+     * @pre Balances locked by the previous contract version not migrated yet (see `migratelocks`),
+     * @pre Handshake has not any DHS token locked,
+     * @pre Dealer has not locked exactly the price plus the stake,
+     * @pre Bidder has not locked exactly the stake,
+     * @pre Winner must be dealer or bidder,
+     * @pre Jurors must be not empty.
      * 
-     * If validation is successful the right amounts of tokens will be subtracted from the locked balances of dealer and bidder. The loser stake
-     * will be redistributed to the jurors that have voted for the winner. The winner can retrieve the tokens without any loss.
+     * If validation is successful the locked tokens are redistributed and the ledger row is erased. The loser stake will be split in equal
+     * parts between the jurors (the first one gets the remainder). The winner can retrieve the tokens without any loss.
      */
-    [[eosio::action]] void resolved(eosio::name dhsservice, eosio::name dealer, eosio::name bidder, eosio::asset price, vector<eosio::name> jurors, uint8_t winner);
-};
\ No newline at end of file
+    [[eosio::action]] void resolved(eosio::name dhsservice, int32_t dhs_id, eosio::asset price, vector<eosio::name> jurors, uint8_t winner);
+};
@@ -1,13 +1,16 @@
 #include "dhsservice.hpp"
 
-void dhsservice::signup(eosio::name username, uint8_t role, std::string external_data_hash)
+void dhsservice::signup(eosio::name username, uint8_t role, eosio::checksum256 external_data_hash)
 {
     // Ensure the user authorizes this action.
     require_auth(username);
 
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("signup");
+
     // Verify input data.
     check(role == USER || role == JUROR, "signup: INVALID ROLE");
-    check(external_data_hash.length() == 64, "signup: INVALID EXTERNAL DATA HASH");
+    check(external_data_hash != eosio::checksum256(), "signup: INVALID EXTERNAL DATA HASH");
 
     // Verify if the user is already registered as user.
     auto existing_user = _users.find(username.value);
@@ -25,6 +28,8 @@ void dhsservice::signup(eosio::name username, uint8_t role, std::string external
             new_user.rating = 0;
             new_user.info.external_data_hash = external_data_hash;
         });
+
+        get_stats().users += 1;
     }
     if (role == JUROR)
     {
@@ -33,35 +38,305 @@ void dhsservice::signup(eosio::name username, uint8_t role, std::string external
             new_juror.info.username = username;
             new_juror.info.external_data_hash = external_data_hash;
         });
+
+        // Make the juror eligible for disputes.
+        add_pool_juror(username);
+
+        get_stats().jurors += 1;
+    }
+}
+
+void dhsservice::unregjuror(eosio::name juror)
+{
+    // Ensure the juror authorizes this action.
+    require_auth(juror);
+
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("unregjuror");
+
+    // Verify if the user is registered as juror.
+    auto existing_juror = _jurors.find(juror.value);
+    check(existing_juror != _jurors.end(), "unregjuror: JUROR NOT REGISTERED");
+
+    // Verify that the juror has no dispute still waiting for its vote.
+    auto slots_by_juror = _juror_slots.get_index<"byjuror"_n>();
+    auto juror_slot = slots_by_juror.find(juror.value);
+
+    check(juror_slot == slots_by_juror.end() || juror_slot->load == 0, "unregjuror: JUROR HAS OPEN DISPUTES");
+
+    // Unregister the juror.
+    _jurors.erase(existing_juror);
+    remove_pool_juror(juror);
+
+    // The counter is seeded by the `migratehash` action for the jurors registered by the previous contract version.
+    auto &stats = get_stats();
+    check(stats.jurors > 0, "unregjuror: JURORS COUNTER NOT SEEDED");
+    stats.jurors -= 1;
+}
+
+void dhsservice::seedpool(eosio::name from, uint32_t max_rows)
+{
+    // Ensure the contract authorizes this action.
+    require_auth(get_self());
+
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("seedpool");
+
+    auto slots_by_juror = _juror_slots.get_index<"byjuror"_n>();
+
+    for (auto itr = _jurors.lower_bound(from.value); itr != _jurors.end() && max_rows > 0; itr++, max_rows--)
+    {
+        // Add only the jurors which are not in the pool yet.
+        if (slots_by_juror.find(itr->info.username.value) == slots_by_juror.end())
+            add_pool_juror(itr->info.username);
+    }
+}
+
+void dhsservice::seedreqid()
+{
+    // Ensure the contract authorizes this action.
+    require_auth(get_self());
+
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("seedreqid");
+
+    // Verify if the counter has already been seeded.
+    check(!_request_counter.exists(), "seedreqid: COUNTER ALREADY SEEDED");
+
+    // Seed the counter from the requests table.
+    _request_counter.set(request_counter{get_last_request_id()}, get_self());
+}
+
+void dhsservice::migratehash(uint32_t max_rows)
+{
+    // Ensure the contract authorizes this action.
+    require_auth(get_self());
+
+    // Verify input data.
+    check(max_rows > 0, "migratehash: INVALID MAX ROWS");
+
+    // Verify if the migration is already done.
+    hash_migration migration = _hash_migration.get_or_default();
+    check(migration.step != MIGRATION_DONE, "migratehash: MIGRATION ALREADY DONE");
+
+    // Converter of the rows without child rows.
+    auto no_child_rows = [](const auto &, uint32_t child, uint32_t &) { return child; };
+
+    while (max_rows > 0 && migration.step != MIGRATION_DONE)
+    {
+        bool table_done = false;
+
+        switch (migration.step)
+        {
+        case MIGRATE_USERS:
+            table_done = migrate_rows<"users"_n, legacy_user>(migration, max_rows, no_child_rows, [&](const legacy_user &row) {
+                user migrated{{row.info.username, decode_hash(row.info.external_data_hash)}, row.rating};
+
+                // The legacy users table had no secondary index, store the `byrating` entry of the row.
+                store_secondary("users"_n, 0, migrated.primary_key(), migrated.rating_secondary());
+
+                get_stats().users += 1;
+                return migrated;
+            });
+            break;
+        case MIGRATE_JURORS:
+            table_done = migrate_rows<"jurors"_n, legacy_juror>(
+                migration, max_rows,
+                [&](const legacy_juror &row, uint32_t child, uint32_t &budget) {
+                    // Make the juror eligible for disputes (the previous contract version had no juror pool).
+                    auto slots_by_juror = _juror_slots.get_index<"byjuror"_n>();
+
+                    if (child == 0 && slots_by_juror.find(row.info.username.value) == slots_by_juror.end())
+                    {
+                        add_pool_juror(row.info.username);
+                        budget--;
+                    }
+
+                    return uint32_t(1);
+                },
+                [&](const legacy_juror &row) {
+                    get_stats().jurors += 1;
+                    return juror{{row.info.username, decode_hash(row.info.external_data_hash)}};
+                });
+            break;
+        case MIGRATE_REQUESTS:
+            table_done = migrate_rows<"requests"_n, legacy_request>(
+                migration, max_rows,
+                [&](const legacy_request &row, uint32_t child, uint32_t &budget) {
+                    // Move the bidders list into the proposals table (the list has the last bidder first, the ids follow the proposal order).
+                    for (; child < row.bidders.size() && budget > 0; child++, budget--)
+                    {
+                        _proposals.emplace(get_self(), [&](auto &new_proposal) {
+                            new_proposal.id = _proposals.available_primary_key();
+                            new_proposal.request_id = row.id;
+                            new_proposal.bidder = row.bidders[row.bidders.size() - 1 - child];
+                        });
+                    }
+
+                    return child;
+                },
+                [&](const legacy_request &row) {
+                    request migrated{row.id, row.dealer, row.summary, decode_hash(row.contractual_terms_hash), row.price, row.deadline, row.status, row.bidder};
+
+                    // The legacy requests table had no secondary index, store the `bystatus`, `bydealer` and `bydeadline` entries of the row.
+                    store_secondary("requests"_n, 0, migrated.primary_key(), migrated.status_secondary());
+                    store_secondary("requests"_n, 1, migrated.primary_key(), migrated.dealer_secondary());
+                    store_secondary("requests"_n, 2, migrated.primary_key(), migrated.deadline_secondary());
+
+                    get_stats().open_requests += row.status == OPEN ? 1 : 0;
+                    return migrated;
+                });
+            break;
+        case MIGRATE_HANDSHAKES:
+            table_done = migrate_rows<"handshakes"_n, legacy_digital_handshake>(
+                migration, max_rows,
+                [&](const legacy_digital_handshake &row, uint32_t child, uint32_t &budget) {
+                    legacy_negotiations_table legacy_negotiations(get_self(), get_self().value);
+                    auto existing_negotiation = legacy_negotiations.find(row.request_id);
+
+                    if (existing_negotiation == legacy_negotiations.end())
+                        return child;
+
+                    const auto &hashes = existing_negotiation->proposed_contractual_terms_hashes;
+                    const auto &prices = existing_negotiation->proposed_prices;
+                    const auto &deadlines = existing_negotiation->proposed_deadlines;
+
+                    // The three vectors grow together, one element per proposal (the first one copies the request terms).
+                    check(hashes.size() == prices.size() && prices.size() == deadlines.size(), "migratehash: INVALID NEGOTIATION ROW");
+
+                    // Store one rounds row per proposal of the negotiation history.
+                    for (; child < prices.size() && budget > 0; child++, budget--)
+                        store_round(get_self(), row.request_id, child, decode_hash(hashes[child]), prices[child], deadlines[child]);
+
+                    return child;
+                },
+                [&](const legacy_digital_handshake &row) {
+                    legacy_negotiations_table legacy_negotiations(get_self(), get_self().value);
+                    auto existing_negotiation = legacy_negotiations.find(row.request_id);
+
+                    digital_handshake handshake{row.request_id, row.dealer, row.bidder, row.price, row.deadline, decode_hash(row.contractual_terms_hash),
+                                                row.status, 0, false, false, false, false, row.unlock_for_expiration_by_dealer, row.unlock_for_expiration_by_bidder};
+
+                    // Fold the negotiation row into the handshake (the current terms are the last proposal while negotiating).
+                    if (existing_negotiation != legacy_negotiations.end())
+                    {
+                        const auto &hashes = existing_negotiation->proposed_contractual_terms_hashes;
+                        const auto &prices = existing_negotiation->proposed_prices;
+                        const auto &deadlines = existing_negotiation->proposed_deadlines;
+
+                        handshake.rounds = prices.size();
+                        handshake.accepted_by_dealer = existing_negotiation->accepted_by_dealer;
+                        handshake.accepted_by_bidder = existing_negotiation->accepted_by_bidder;
+                        handshake.lock_by_dealer = existing_negotiation->lock_by_dealer;
+                        handshake.lock_by_bidder = existing_negotiation->lock_by_bidder;
+
+                        if (row.status == NEGOTIATION && !prices.empty())
+                        {
+                            handshake.contractual_terms_hash = decode_hash(hashes.back());
+                            handshake.price = prices.back();
+                            handshake.deadline = deadlines.back();
+                        }
+
+                        legacy_negotiations.erase(existing_negotiation);
+                    }
+
+                    // The legacy handshakes table had no secondary index, store the `bydealer`, `bybidder` and `bystatusdl` entries of the row.
+                    store_secondary("handshakes"_n, 0, handshake.primary_key(), handshake.dealer_secondary());
+                    store_secondary("handshakes"_n, 1, handshake.primary_key(), handshake.bidder_secondary());
+                    store_secondary("handshakes"_n, 2, handshake.primary_key(), handshake.status_deadline_secondary());
+
+                    // Count the migrated handshake in the statistics.
+                    count_status(NO_STATUS, row.status);
+
+                    return handshake;
+                });
+            break;
+        case MIGRATE_DISPUTES:
+            table_done = migrate_rows<"disputes"_n, legacy_dispute>(
+                migration, max_rows,
+                [&](const legacy_dispute &row, uint32_t child, uint32_t &budget) {
+                    const eosio::name jurors[] = {row.juror1, row.juror2, row.juror3};
+                    const eosio::name votes[] = {row.vote1, row.vote2, row.vote3};
+
+                    // Assign the disputes still waiting for a vote (one child per juror of the panel, only the assignments are charged).
+                    for (; child < 3 && budget > 0; child++)
+                    {
+                        if (!votes[child])
+                        {
+                            add_assignment(get_self(), jurors[child], row.dhs_id);
+                            budget--;
+                        }
+                    }
+
+                    return child;
+                },
+                [&](const legacy_dispute &row) {
+                    const eosio::name votes[] = {row.vote1, row.vote2, row.vote3};
+                    vector<eosio::name> jurors = {row.juror1, row.juror2, row.juror3};
+                    uint16_t voted = 0;
+                    uint16_t votes_for_bidder = 0;
+
+                    // Fold the juror votes into the panel bitmasks.
+                    for (uint8_t i = 0; i < jurors.size(); i++)
+                    {
+                        voted |= votes[i] ? (1 << i) : 0;
+                        votes_for_bidder |= votes[i] == row.bidder ? (1 << i) : 0;
+                    }
+
+                    // The legacy disputes had an index per juror (`j1secid`, `j2secid` and `j3secid`), remove the entries of the row.
+                    for (uint8_t i = 0; i < jurors.size(); i++)
+                        remove_secondary("disputes"_n, i, row.primary_key());
+
+                    return dispute{row.dhs_id, row.dealer, row.bidder, jurors, voted, votes_for_bidder,
+                                   decode_hash(row.dealer_motivation_hash), decode_hash(row.bidder_motivation_hash)};
+                });
+            break;
+        }
+
+        // Move to the next table.
+        if (table_done)
+        {
+            migration.step += 1;
+            migration.cursor = 0;
+            migration.child = 0;
+        }
     }
+
+    _hash_migration.set(migration, get_self());
 }
 
 void dhsservice::postrequest(
     eosio::name dealer,
     std::string summary,
-    std::string contractual_terms_hash,
+    eosio::checksum256 contractual_terms_hash,
     eosio::asset price,
     uint32_t deadline)
 {
     // Ensure the dealer authorizes this action.
     require_auth(dealer);
 
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("postrequest");
+
     // Verify if the dealer is already registered as user.
     auto existing_dealer = _users.find(dealer.value);
     check(existing_dealer != _users.end(), "postrequest: USER NOT REGISTERED");
 
     // Verify price.
     check(price.amount > 0, "postrequest: ZERO OR NEGATIVE PRICE");
-    check(price.symbol == dhs_symbol, "postrequest: NOT DHS TOKEN");
+    check(price.symbol == dhs::token_symbol, "postrequest: NOT DHS TOKEN");
 
     // Verify other input data.
     check(summary.length() > 0, "postrequest: EMPTY SUMMARY");
-    check(contractual_terms_hash.length() == 64, "postrequest: INVALID CONTRACTUAL TERMS HASH");
+    check(contractual_terms_hash != eosio::checksum256(), "postrequest: INVALID CONTRACTUAL TERMS HASH");
     check(deadline > now(), "postrequest: WRONG DEADLINE");
 
+    // Allocate the request identifier.
+    int32_t request_id = next_request_id();
+
     // Post the new request.
     _requests.emplace(dealer, [&](auto &new_request) {
-        new_request.id = get_last_request_id() + 1;
+        new_request.id = request_id;
         new_request.dealer = dealer;
         new_request.summary = summary;
         new_request.contractual_terms_hash = contractual_terms_hash;
@@ -69,6 +344,8 @@ void dhsservice::postrequest(
         new_request.deadline = deadline;
         new_request.status = OPEN;
     });
+
+    get_stats().open_requests += 1;
 }
 
 void dhsservice::propose(eosio::name bidder, int32_t request_id)
@@ -76,26 +353,62 @@ void dhsservice::propose(eosio::name bidder, int32_t request_id)
     // Ensure the bidder authorizes this action.
     require_auth(bidder);
 
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("propose");
+
     // Verify if the bidder is already registered as user.
     auto existing_bidder = _users.find(bidder.value);
     check(existing_bidder != _users.end(), "propose: USER NOT REGISTERED");
 
-    // Verify request.
-    auto existing_request = _requests.find(request_id);
+    // Verify the request and store the proposal.
+    const char *failure = try_propose(bidder, request_id);
 
-    check(existing_request != _requests.end(), "propose: REQUEST NOT POSTED");
-    check(existing_request->status == OPEN, "propose: REQUEST NOT OPEN");
-    check(existing_request->dealer != bidder, "propose: REQUEST DEALER CANNOT PROPOSE");
+    if (failure != nullptr)
+        check(false, std::string("propose: ") + failure);
+}
 
-    auto bidders = existing_request->bidders;
-    check(std::find(bidders.begin(), bidders.end(), bidder) == bidders.end(), "propose: USER ALREADY PROPOSED");
+void dhsservice::batchpropose(eosio::name bidder, std::vector<int32_t> request_ids)
+{
+    // Ensure the bidder authorizes this action.
+    require_auth(bidder);
 
-    // Update the request.
-    bidders.insert(bidders.begin(), bidder);
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("batchpropose");
 
-    _requests.modify(existing_request, bidder, [&](auto &request) {
-        request.bidders = bidders;
-    });
+    // Verify if the bidder is already registered as user.
+    auto existing_bidder = _users.find(bidder.value);
+    check(existing_bidder != _users.end(), "batchpropose: USER NOT REGISTERED");
+
+    // Verify input data.
+    check(request_ids.size() > 0 && request_ids.size() <= max_batch_proposals, "batchpropose: INVALID BATCH SIZE");
+
+    // Store the proposals, collecting the requests which fail instead of aborting the batch.
+    std::vector<batch_failure> failures;
+
+    for (int32_t request_id : request_ids)
+    {
+        const char *failure = try_propose(bidder, request_id);
+
+        if (failure != nullptr)
+            failures.push_back(batch_failure{request_id, failure});
+    }
+
+    if (!failures.empty())
+    {
+        // Inline failures notification.
+        action{
+            permission_level{get_self(), "active"_n},
+            get_self(),
+            "logbatch"_n,
+            std::make_tuple(bidder, failures)}
+            .send();
+    }
+}
+
+void dhsservice::logbatch(eosio::name /* bidder */, std::vector<batch_failure> /* failures */)
+{
+    // Only the contract notifies failed batch proposals, the failures live in the action traces.
+    require_auth(get_self());
 }
 
 void dhsservice::selectbidder(eosio::name dealer, eosio::name bidder, int32_t request_id)
@@ -103,6 +416,9 @@ void dhsservice::selectbidder(eosio::name dealer, eosio::name bidder, int32_t re
     // Ensure the dealer authorizes this action.
     require_auth(dealer);
 
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("selectbidder");
+
     // Verify if the dealer is already registered as user.
     auto existing_dealer = _users.find(dealer.value);
     check(existing_dealer != _users.end(), "selectbidder: USER NOT REGISTERED");
@@ -116,8 +432,8 @@ void dhsservice::selectbidder(eosio::name dealer, eosio::name bidder, int32_t re
     // Verify users.
     check(existing_request->dealer == dealer, "selectbidder: NOT REQUEST DEALER");
 
-    auto bidders = existing_request->bidders;
-    check(std::find(bidders.begin(), bidders.end(), bidder) != bidders.end(), "selectbidder: NOT BIDDER FOR THE REQUEST");
+    auto proposals_by_request = _proposals.get_index<"byrequest"_n>();
+    check(proposals_by_request.find(proposal_key(request_id, bidder)) != proposals_by_request.end(), "selectbidder: NOT BIDDER FOR THE REQUEST");
 
     // Update the request with the selected bidder.
     _requests.modify(existing_request, dealer, [&](auto &request) {
@@ -125,80 +441,77 @@ void dhsservice::selectbidder(eosio::name dealer, eosio::name bidder, int32_t re
         request.status = CLOSED;
     });
 
-    // Store a new digital handshake for the request.
+    // The counter is seeded by the `migratehash` action for the requests posted by the previous contract version.
+    auto &stats = get_stats();
+    check(stats.open_requests > 0, "selectbidder: OPEN REQUESTS COUNTER NOT SEEDED");
+    stats.open_requests -= 1;
+
+    // Store a new digital handshake for the request, starting the negotiation from the request terms.
     _handshakes.emplace(dealer, [&](auto &new_digital_handshake) {
         new_digital_handshake.request_id = existing_request->id;
         new_digital_handshake.dealer = dealer;
         new_digital_handshake.bidder = bidder;
+        new_digital_handshake.price = existing_request->price;
+        new_digital_handshake.deadline = existing_request->deadline;
+        new_digital_handshake.contractual_terms_hash = existing_request->contractual_terms_hash;
         new_digital_handshake.status = NEGOTIATION;
+        new_digital_handshake.rounds = 1;
+        new_digital_handshake.accepted_by_dealer = false;
+        new_digital_handshake.accepted_by_bidder = false;
+        new_digital_handshake.lock_by_dealer = false;
+        new_digital_handshake.lock_by_bidder = false;
+        new_digital_handshake.unlock_for_expiration_by_dealer = false;
+        new_digital_handshake.unlock_for_expiration_by_bidder = false;
     });
 
-    // Store the first negotiation copying the request information.
-    _negotiations.emplace(dealer, [&](auto &new_negotiation) {
-        new_negotiation.dhs_id = existing_request->id;
-        new_negotiation.proposed_contractual_terms_hashes = {existing_request->contractual_terms_hash};
-        new_negotiation.proposed_prices = {existing_request->price};
-        new_negotiation.proposed_deadlines = {existing_request->deadline};
-    });
+    count_status(NO_STATUS, NEGOTIATION);
+
+    // Append the request terms as the first negotiation round.
+    store_round(dealer, existing_request->id, 0, existing_request->contractual_terms_hash, existing_request->price, existing_request->deadline);
 }
 
-void dhsservice::negotiate(eosio::name user, int32_t dhs_id, std::string contractual_terms_hash, eosio::asset price, uint32_t deadline)
+void dhsservice::negotiate(eosio::name user, int32_t dhs_id, eosio::checksum256 contractual_terms_hash, eosio::asset price, uint32_t deadline)
 {
     // Ensure the user authorizes this action.
     require_auth(user);
 
-    // Verify if the user is already registered as user.
-    auto existing_user = _users.find(user.value);
-    check(existing_user != _users.end(), "negotiate: USER NOT REGISTERED");
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("negotiate");
 
-    // Verify handshake.
-    auto existing_handshake = _handshakes.find(dhs_id);
-
-    check(existing_handshake != _handshakes.end(), "negotiate: HANDSHAKE NOT EXIST");
-    check(existing_handshake->status == NEGOTIATION, "negotiate: HANDSHAKE NOT NEGOTIATION STATUS");
-
-    // Verify if the user is the dealer/bidder of the handshake.
-    check(existing_handshake->dealer == user || existing_handshake->bidder == user, "negotiate: USER NOT HANDSHAKE PARTICIPANT");
-
-    // Verify negotiation.
-    auto existing_negotiation = _negotiations.find(dhs_id);
+    // Verify user, handshake and if the user is the dealer/bidder of the handshake.
+    auto context = load_participant<NEGOTIATION, ANY_PARTICIPANT>(user, dhs_id, "negotiate");
+    auto existing_handshake = context.handshake;
 
     // Check if the terms have been already accepted.
-    check(existing_negotiation->accepted_by_dealer == false && existing_negotiation->accepted_by_bidder == false, "negotiate: ALREADY ACCEPTED TERMS");
+    check(existing_handshake->accepted_by_dealer == false && existing_handshake->accepted_by_bidder == false, "negotiate: ALREADY ACCEPTED TERMS");
 
     // Verify other input data.
-    check(contractual_terms_hash.length() == 64, "negotiate: INVALID CONTRACTUAL TERMS HASH");
+    check(contractual_terms_hash != eosio::checksum256(), "negotiate: INVALID CONTRACTUAL TERMS HASH");
     check(price.amount > 0, "negotiate: ZERO OR NEGATIVE PRICE");
-    check(price.symbol == dhs_symbol, "negotiate: NOT DHS TOKEN");
+    check(price.symbol == dhs::token_symbol, "negotiate: NOT DHS TOKEN");
     check(deadline > now(), "negotiate: WRONG DEADLINE");
 
-    if (existing_handshake->dealer == user)
+    if (context.is_dealer)
     { // Dealer.
 
         // Check if it is the dealer turns to negotiate.
-        check(existing_negotiation->proposed_prices.size() % 2 == 0, "negotiate: NOT DEALER TURN");
+        check(existing_handshake->rounds % 2 == 0, "negotiate: NOT DEALER TURN");
     }
     else
     { // Bidder.
         // Check if it is the bidder turns to negotiate.
-        check(existing_negotiation->proposed_prices.size() % 2 == 1, "negotiate: NOT BIDDER TURN");
+        check(existing_handshake->rounds % 2 == 1, "negotiate: NOT BIDDER TURN");
     }
 
-    // Update the negotiation row vectors.
-    auto proposed_contractual_terms_hashes = existing_negotiation->proposed_contractual_terms_hashes;
-    proposed_contractual_terms_hashes.insert(proposed_contractual_terms_hashes.end(), contractual_terms_hash);
-
-    auto proposed_prices = existing_negotiation->proposed_prices;
-    proposed_prices.insert(proposed_prices.end(), price);
-
-    auto proposed_deadlines = existing_negotiation->proposed_deadlines;
-    proposed_deadlines.insert(proposed_deadlines.end(), deadline);
+    // Append the new proposal to the negotiation history.
+    store_round(user, dhs_id, existing_handshake->rounds, contractual_terms_hash, price, deadline);
 
-    // Update the negotiation with the new proposal.
-    _negotiations.modify(existing_negotiation, user, [&](auto &negotiation) {
-        negotiation.proposed_contractual_terms_hashes = proposed_contractual_terms_hashes;
-        negotiation.proposed_prices = proposed_prices;
-        negotiation.proposed_deadlines = proposed_deadlines;
+    // Update the handshake with the new proposal.
+    _handshakes.modify(existing_handshake, user, [&](auto &handshake) {
+        handshake.rounds += 1;
+        handshake.contractual_terms_hash = contractual_terms_hash;
+        handshake.price = price;
+        handshake.deadline = deadline;
     });
 }
 
@@ -207,65 +520,45 @@ void dhsservice::acceptterms(eosio::name user, int32_t dhs_id)
     // Ensure the user authorizes this action.
     require_auth(user);
 
-    // Verify if the user is already registered as user.
-    auto existing_user = _users.find(user.value);
-    check(existing_user != _users.end(), "acceptterms: USER NOT REGISTERED");
-
-    // Verify handshake.
-    auto existing_handshake = _handshakes.find(dhs_id);
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("acceptterms");
 
-    check(existing_handshake != _handshakes.end(), "acceptterms: HANDSHAKE NOT EXIST");
-    check(existing_handshake->status == NEGOTIATION, "acceptterms: HANDSHAKE NOT NEGOTIATION STATUS");
+    // Verify user, handshake and if the user is the dealer/bidder of the handshake.
+    auto context = load_participant<NEGOTIATION, ANY_PARTICIPANT>(user, dhs_id, "acceptterms");
+    auto existing_handshake = context.handshake;
 
-    // Verify if the user is the dealer/bidder of the handshake.
-    check(existing_handshake->dealer == user || existing_handshake->bidder == user, "acceptterms: USER NOT HANDSHAKE PARTICIPANT");
-
-    auto existing_negotiation = _negotiations.find(dhs_id);
     asset user_balance = get_user_balance(user);
 
-    if (existing_handshake->dealer == user)
+    if (context.is_dealer)
     { // Dealer.
         // Verify dealer balance.
-        check(user_balance.amount / 10000 - fixed_stake.amount >= existing_negotiation->proposed_prices.back().amount / 10000, "acceptterms: NOT ENOUGH BALANCE FOR DEALER");
+        check(user_balance.amount - dhs::stake_amount >= existing_handshake->price.amount, "acceptterms: NOT ENOUGH BALANCE FOR DEALER");
 
         // Check if the bidder has already accepted or if it is the turn of the dealer for accepting terms.
-        check(existing_negotiation->accepted_by_bidder == true || existing_negotiation->proposed_prices.size() % 2 == 0, "acceptterms: NOT DEALER TURN");
+        check(existing_handshake->accepted_by_bidder == true || existing_handshake->rounds % 2 == 0, "acceptterms: NOT DEALER TURN");
 
         // Check if the dealer has already accepted.
-        check(existing_negotiation->accepted_by_dealer == false, "acceptterms: DEALER ALREADY ACCEPTED TERMS");
-
-        // Update the negotiation.
-        _negotiations.modify(existing_negotiation, user, [&](auto &negotiation) {
-            negotiation.accepted_by_dealer = true;
-        });
+        check(existing_handshake->accepted_by_dealer == false, "acceptterms: DEALER ALREADY ACCEPTED TERMS");
     }
     else
     { // Bidder.
         // Verify bidder balance.
-        check(user_balance.amount / 10000 >= fixed_stake.amount, "acceptterms: NOT ENOUGH BALANCE FOR BIDDER");
+        check(user_balance.amount >= dhs::stake_amount, "acceptterms: NOT ENOUGH BALANCE FOR BIDDER");
 
         // Check if the dealer has already accepted or if it is the turn of the bidder for accepting terms.
-        check(existing_negotiation->accepted_by_dealer == true || existing_negotiation->proposed_prices.size() % 2 == 1, "acceptterms: NOT BIDDER TURN");
+        check(existing_handshake->accepted_by_dealer == true || existing_handshake->rounds % 2 == 1, "acceptterms: NOT BIDDER TURN");
 
         // Check if the bidder has already accepted.
-        check(existing_negotiation->accepted_by_bidder == false, "acceptterms: BIDDER ALREADY ACCEPTED TERMS");
-
-        // Update the negotiation.
-        _negotiations.modify(existing_negotiation, user, [&](auto &negotiation) {
-            negotiation.accepted_by_bidder = true;
-        });
+        check(existing_handshake->accepted_by_bidder == false, "acceptterms: BIDDER ALREADY ACCEPTED TERMS");
     }
 
-    if (existing_negotiation->accepted_by_dealer == true && existing_negotiation->accepted_by_bidder == true)
-    {
-        // Update handshake terms and status when both dealer and bidder have accepted the terms.
-        _handshakes.modify(existing_handshake, user, [&](auto &handshake) {
-            handshake.contractual_terms_hash = existing_negotiation->proposed_contractual_terms_hashes.back();
-            handshake.price = existing_negotiation->proposed_prices.back();
-            handshake.deadline = existing_negotiation->proposed_deadlines.back();
-            handshake.status = LOCK;
-        });
-    }
+    // Update the handshake acceptance, moving to the lock of the tokens when both dealer and bidder have accepted the terms.
+    _handshakes.modify(existing_handshake, user, [&](auto &handshake) {
+        (context.is_dealer ? handshake.accepted_by_dealer : handshake.accepted_by_bidder) = true;
+
+        if (handshake.accepted_by_dealer == true && handshake.accepted_by_bidder == true)
+            set_status<NEGOTIATION, LOCK>(handshake);
+    });
 }
 
 void dhsservice::notifylock(eosio::name from, eosio::name to, eosio::asset quantity, std::string memo)
@@ -278,89 +571,51 @@ void dhsservice::notifylock(eosio::name from, eosio::name to, eosio::asset quant
         return;
     }
 
-    // Verify if the user is recorded as a user.
-    auto existing_user = _users.find(from.value);
-    check(existing_user != _users.end(), "notifylock: USER NOT REGISTERED");
-
-    // Verify handshake (the memo must contain an handshake identifier related to an handshake with a LOCK status).
-    auto identifier = std::stoi(memo);
-    auto existing_handshake = _handshakes.find(identifier);
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("notifylock");
 
-    check(existing_handshake != _handshakes.end(), "notifylock: HANDSHAKE NOT EXIST");
-    check(existing_handshake->status == LOCK, "notifylock: HANDSHAKE NOT LOCK STATUS");
+    // Verify the token (amounts are compared in base units below).
+    check(quantity.symbol == dhs::token_symbol, "notifylock: NOT DHS TOKEN");
 
-    // Verify if the user is the dealer/bidder of the handshake.
-    check(existing_handshake->dealer == from || existing_handshake->bidder == from, "notifylock: USER NOT HANDSHAKE PARTICIPANT");
+    // Verify user and handshake (the memo must contain an handshake identifier related to an handshake with a LOCK status).
+    int32_t identifier = 0;
+    check(parse_dhs_id(memo, identifier), "notifylock: INVALID MEMO");
 
-    auto existing_negotiation = _negotiations.find(identifier);
+    auto context = load_participant<LOCK, ANY_PARTICIPANT>(from, identifier, "notifylock");
+    auto existing_handshake = context.handshake;
 
-    if (existing_handshake->dealer == from)
+    if (context.is_dealer)
     {
         // Verify the amount paid.
-        check(quantity.amount / 10000 - fixed_stake.amount == existing_handshake->price.amount / 10000, "notifylock: NOT CORRECT QUANTITY LOCKED BY DEALER");
+        check(quantity.amount - dhs::stake_amount == existing_handshake->price.amount, "notifylock: NOT CORRECT QUANTITY LOCKED BY DEALER");
 
         // Verify that the dealer has not already paid for the handshake.
-        check(existing_negotiation->lock_by_dealer == false, "notifylock: DEALER ALREADY LOCKED TOKENS");
-
-        // Inline transfer.
-        action{
-            permission_level{get_self(), "active"_n},
-            "dhstoken"_n,
-            "transfer"_n,
-            std::make_tuple(get_self(), "dhsescrow"_n, quantity, memo)}
-            .send();
-
-        // Inline lock.
-        action{
-            permission_level{get_self(), "active"_n},
-            "dhsescrow"_n,
-            "locktokens"_n,
-            std::make_tuple(get_self(), from, quantity)}
-            .send();
-
-        // Update the negotiation with dealer payment lock.
-        _negotiations.modify(existing_negotiation, get_self(), [&](auto &negotiation) {
-            negotiation.lock_by_dealer = true;
-        });
+        check(existing_handshake->lock_by_dealer == false, "notifylock: DEALER ALREADY LOCKED TOKENS");
     }
-
-    if (existing_handshake->bidder == from)
+    else
     {
         // Verify the amount paid.
-        check(quantity.amount / 10000 == fixed_stake.amount, "notifylock: NOT CORRECT QUANTITY LOCKED BY BIDDER");
+        check(quantity.amount == dhs::stake_amount, "notifylock: NOT CORRECT QUANTITY LOCKED BY BIDDER");
 
         // Verify that the bidder has not already paid for the handshake.
-        check(existing_negotiation->lock_by_bidder == false, "notifylock: BIDDER ALREADY LOCKED TOKENS");
-
-        // Inline transfer.
-        action{
-            permission_level{get_self(), "active"_n},
-            "dhstoken"_n,
-            "transfer"_n,
-            std::make_tuple(get_self(), "dhsescrow"_n, quantity, memo)}
-            .send();
+        check(existing_handshake->lock_by_bidder == false, "notifylock: BIDDER ALREADY LOCKED TOKENS");
+    }
 
-        // Inline lock.
-        action{
-            permission_level{get_self(), "active"_n},
-            "dhsescrow"_n,
-            "locktokens"_n,
-            std::make_tuple(get_self(), from, quantity)}
-            .send();
+    // Inline transfer (the dhsescrow contract tracks the locked tokens from the transfer notification, the memo reports the user and its role).
+    action{
+        permission_level{get_self(), "active"_n},
+        "dhstoken"_n,
+        "transfer"_n,
+        std::make_tuple(get_self(), "dhsescrow"_n, quantity, from.to_string() + ":" + memo + (context.is_dealer ? ":dealer" : ":bidder"))}
+        .send();
 
-        // Update the negotiation with bidder payment lock.
-        _negotiations.modify(existing_negotiation, get_self(), [&](auto &negotiation) {
-            negotiation.lock_by_bidder = true;
-        });
-    }
+    // Update the handshake with the payment lock, moving to the execution when both dealer and bidder have locked the tokens.
+    _handshakes.modify(existing_handshake, get_self(), [&](auto &handshake) {
+        (context.is_dealer ? handshake.lock_by_dealer : handshake.lock_by_bidder) = true;
 
-    if (existing_negotiation->lock_by_dealer == true && existing_negotiation->lock_by_bidder == true)
-    {
-        // Update handshake status.
-        _handshakes.modify(existing_handshake, get_self(), [&](auto &handshake) {
-            handshake.status = EXECUTION;
-        });
-    }
+        if (handshake.lock_by_dealer == true && handshake.lock_by_bidder == true)
+            set_status<LOCK, EXECUTION>(handshake);
+    });
 }
 
 void dhsservice::endjob(eosio::name bidder, int32_t dhs_id)
@@ -368,25 +623,18 @@ void dhsservice::endjob(eosio::name bidder, int32_t dhs_id)
     // Ensure the bidder authorized this action.
     require_auth(bidder);
 
-    // Verify if the bidder is recorded as a user.
-    auto existing_user = _users.find(bidder.value);
-    check(existing_user != _users.end(), "endjob: USER NOT REGISTERED");
-
-    // Verify handshake.
-    auto existing_handshake = _handshakes.find(dhs_id);
-
-    check(existing_handshake != _handshakes.end(), "endjob: HANDSHAKE NOT EXIST");
-    check(existing_handshake->status == EXECUTION, "endjob: HANDSHAKE NOT EXECUTION STATUS");
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("endjob");
 
-    // Verify if the user is the bidder of the handshake.
-    check(existing_handshake->bidder == bidder, "endjob: USER NOT HANDSHAKE BIDDER");
+    // Verify user, handshake and if the user is the bidder of the handshake.
+    auto existing_handshake = load_participant<EXECUTION, BIDDER_PARTICIPANT>(bidder, dhs_id, "endjob").handshake;
 
     // Verify if the deadline is already expired.
     check(existing_handshake->deadline > now(), "endjob: EXPIRED DEADLINE");
 
     // Update handshake status.
     _handshakes.modify(existing_handshake, get_self(), [&](auto &handshake) {
-        handshake.status = CONFIRMATION;
+        set_status<EXECUTION, CONFIRMATION>(handshake);
     });
 }
 
@@ -395,23 +643,17 @@ void dhsservice::expired(eosio::name user, int32_t dhs_id)
     // Ensure the user authorized this action.
     require_auth(user);
 
-    // Verify if the user is recorded as a user.
-    auto existing_user = _users.find(user.value);
-    check(existing_user != _users.end(), "expired: USER NOT REGISTERED");
-
-    // Verify handshake.
-    auto existing_handshake = _handshakes.find(dhs_id);
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("expired");
 
-    check(existing_handshake != _handshakes.end(), "expired: HANDSHAKE NOT EXIST");
-    check(existing_handshake->status == EXECUTION, "expired: HANDSHAKE NOT EXECUTION STATUS");
-
-    // Verify if the user is the dealer/bidder of the handshake.
-    check(existing_handshake->dealer == user || existing_handshake->bidder == user, "notifylock: USER NOT HANDSHAKE PARTICIPANT");
+    // Verify user, handshake and if the user is the dealer/bidder of the handshake.
+    auto context = load_participant<EXECUTION, ANY_PARTICIPANT>(user, dhs_id, "expired");
+    auto existing_handshake = context.handshake;
 
     // Verify if the deadline is already expired.
     check(existing_handshake->deadline <= now(), "expired: NOT EXPIRED DEADLINE");
 
-    if (existing_handshake->dealer == user)
+    if (context.is_dealer)
     {
         // Verify if the dealer has already unlocked the tokens for the handshake.
         check(existing_handshake->unlock_for_expiration_by_dealer == false, "expired: DEALER ALREADY UNLOCKED TOKENS");
@@ -421,7 +663,7 @@ void dhsservice::expired(eosio::name user, int32_t dhs_id)
             permission_level{get_self(), "active"_n},
             "dhsescrow"_n,
             "unlocktokens"_n,
-            std::make_tuple(get_self(), user, existing_handshake->price + (fixed_stake * 10000))}
+            std::make_tuple(get_self(), dhs_id, user, dhs::make_asset(existing_handshake->price.amount + dhs::stake_amount))}
             .send();
 
         // Update handshake boolean for dealer.
@@ -430,7 +672,7 @@ void dhsservice::expired(eosio::name user, int32_t dhs_id)
         });
     }
 
-    if (existing_handshake->bidder == user)
+    else
     {
         // Verify if the bidder has already unlocked the tokens for the handshake.
         check(existing_handshake->unlock_for_expiration_by_bidder == false, "expired: BIDDER ALREADY UNLOCKED TOKENS");
@@ -440,7 +682,7 @@ void dhsservice::expired(eosio::name user, int32_t dhs_id)
             permission_level{get_self(), "active"_n},
             "dhsescrow"_n,
             "unlocktokens"_n,
-            std::make_tuple(get_self(), user, (fixed_stake * 10000))}
+            std::make_tuple(get_self(), dhs_id, user, dhs::make_asset(dhs::stake_amount))}
             .send();
 
         // Update handshake boolean for dealer.
@@ -453,8 +695,59 @@ void dhsservice::expired(eosio::name user, int32_t dhs_id)
     {
         // Update handshake status.
         _handshakes.modify(existing_handshake, get_self(), [&](auto &handshake) {
-            handshake.status = EXPIRED;
+            set_status<EXECUTION, EXPIRED>(handshake);
+        });
+    }
+}
+
+void dhsservice::sweepexpired(uint32_t max_rows)
+{
+    // Verify input data (no authorization required, anyone can pay for the sweep).
+    check(max_rows > 0 && max_rows <= max_sweep_rows, "sweepexpired: INVALID MAX ROWS");
+
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("sweepexpired");
+
+    // Visit the handshakes in execution status by deadline.
+    auto handshakes_by_status = _handshakes.get_index<"bystatusdl"_n>();
+    auto itr = handshakes_by_status.lower_bound(uint128_t(EXECUTION) << 64);
+    uint32_t current_time = now();
+
+    while (max_rows > 0 && itr != handshakes_by_status.end() && itr->status == EXECUTION && itr->deadline <= current_time)
+    {
+        // Move to the next handshake before the status (and so the index key) changes.
+        auto existing_handshake = itr++;
+
+        if (existing_handshake->unlock_for_expiration_by_dealer == false)
+        {
+            // Inline unlock for dealer.
+            action{
+                permission_level{get_self(), "active"_n},
+                "dhsescrow"_n,
+                "unlocktokens"_n,
+                std::make_tuple(get_self(), existing_handshake->request_id, existing_handshake->dealer, dhs::make_asset(existing_handshake->price.amount + dhs::stake_amount))}
+                .send();
+        }
+
+        if (existing_handshake->unlock_for_expiration_by_bidder == false)
+        {
+            // Inline unlock for bidder.
+            action{
+                permission_level{get_self(), "active"_n},
+                "dhsescrow"_n,
+                "unlocktokens"_n,
+                std::make_tuple(get_self(), existing_handshake->request_id, existing_handshake->bidder, dhs::make_asset(dhs::stake_amount))}
+                .send();
+        }
+
+        // Update handshake booleans and status.
+        handshakes_by_status.modify(existing_handshake, get_self(), [&](auto &handshake) {
+            handshake.unlock_for_expiration_by_dealer = true;
+            handshake.unlock_for_expiration_by_bidder = true;
+            set_status<EXECUTION, EXPIRED>(handshake);
         });
+
+        max_rows--;
     }
 }
 
@@ -463,33 +756,28 @@ void dhsservice::acceptjob(eosio::name dealer, int32_t dhs_id)
     // Ensure the dealer authorized this action.
     require_auth(dealer);
 
-    // Verify if the dealer is recorded as a user.
-    auto existing_dealer = _users.find(dealer.value);
-    check(existing_dealer != _users.end(), "acceptjob: USER NOT REGISTERED");
-
-    // Verify handshake.
-    auto existing_handshake = _handshakes.find(dhs_id);
-
-    check(existing_handshake != _handshakes.end(), "acceptjob: HANDSHAKE NOT EXIST");
-    check(existing_handshake->status == CONFIRMATION, "acceptjob: HANDSHAKE NOT CONFIRMATION STATUS");
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("acceptjob");
 
-    // Verify if the user is the dealer of the handshake.
-    check(existing_handshake->dealer == dealer, "acceptjob: USER NOT HANDSHAKE DEALER");
+    // Verify user, handshake and if the user is the dealer of the handshake.
+    auto existing_handshake = load_participant<CONFIRMATION, DEALER_PARTICIPANT>(dealer, dhs_id, "acceptjob").handshake;
 
     // Inline unlock.
     action{
         permission_level{get_self(), "active"_n},
         "dhsescrow"_n,
         "accepted"_n,
-        std::make_tuple(get_self(), dealer, existing_handshake->bidder, existing_handshake->price)}
+        std::make_tuple(get_self(), dhs_id, existing_handshake->price)}
         .send();
 
     // Update handshake status.
     _handshakes.modify(existing_handshake, get_self(), [&](auto &handshake) {
-        handshake.status = ACCEPTED;
+        set_status<CONFIRMATION, ACCEPTED>(handshake);
     });
 
     // Update dealer rating.
+    auto existing_dealer = _users.find(dealer.value);
+
     _users.modify(existing_dealer, get_self(), [&](auto &dealer) {
         dealer.rating += 1;
     });
@@ -508,79 +796,79 @@ void dhsservice::opendispute(eosio::name dealer, int32_t dhs_id)
     // Ensure this action is authorized by the dealer.
     require_auth(dealer);
 
-    // Verify if the dealer is recorded as a user.
-    auto existing_dealer = _users.find(dealer.value);
-    check(existing_dealer != _users.end(), "opendispute: USER NOT REGISTERED");
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("opendispute");
 
-    // Verify handshake.
-    auto existing_handshake = _handshakes.find(dhs_id);
+    // Verify user, handshake and if the user is the dealer of the handshake.
+    auto existing_handshake = load_participant<CONFIRMATION, DEALER_PARTICIPANT>(dealer, dhs_id, "opendispute").handshake;
 
-    check(existing_handshake != _handshakes.end(), "opendispute: HANDSHAKE NOT EXIST");
-    check(existing_handshake->status == CONFIRMATION, "opendispute: HANDSHAKE NOT CONFIRMATION STATUS");
+    // Verify if there are enough jurors for the panel.
+    uint64_t pool_size = _juror_pool.get_or_default().size;
+    uint8_t panel_size = _panel_config.get_or_default().size;
 
-    // Verify if the user is the dealer of the handshake.
-    check(existing_handshake->dealer == dealer, "opendispute: USER NOT HANDSHAKE DEALER");
+    check(pool_size >= panel_size, "opendispute: NOT ENOUGH JURORS");
 
-    // Random jurors selection.
-    vector<eosio::name> jurors = get_jurors();
-    int random_juror1_index = random(jurors.size());
-    int random_juror2_index = random(jurors.size());
-    while (random_juror1_index == random_juror2_index)
-    {
-        int random_juror2_index = random(jurors.size());
-    }
-    int random_juror3_index = random(jurors.size());
-    while (random_juror3_index == random_juror1_index || random_juror3_index == random_juror2_index)
+    // Random jurors selection (distinct slots of the juror pool), drawing spare candidates to replace the overloaded jurors.
+    vector<eosio::name> jurors;
+    vector<juror_slot> overloaded;
+
+    for (uint64_t slot : draw_jurors(std::min<uint64_t>(pool_size, panel_size * draws_per_seat), pool_size))
     {
-        int random_juror2_index = random(jurors.size());
+        if (jurors.size() == panel_size)
+            break;
+
+        const auto &candidate = get_pool_slot(slot);
+
+        if (candidate.load < max_juror_load)
+            jurors.push_back(candidate.juror);
+        else
+            overloaded.push_back(candidate);
     }
 
-    // Verify if the user has opened a dispute for the handshake.
-    auto existing_dispute = _disputes.find(dhs_id);
+    // Complete the panel with the least loaded of the overloaded candidates.
+    std::sort(overloaded.begin(), overloaded.end(), [](const auto &a, const auto &b) { return a.load < b.load; });
+
+    for (size_t i = 0; jurors.size() < panel_size; i++)
+        jurors.push_back(overloaded[i].juror);
+
+    for (const auto &juror : jurors)
+        add_assignment(dealer, juror, dhs_id);
 
     // Store a new dispute for the handshake.
     _disputes.emplace(dealer, [&](auto &new_dispute) {
         new_dispute.dhs_id = dhs_id;
         new_dispute.dealer = existing_handshake->dealer;
         new_dispute.bidder = existing_handshake->bidder;
-        new_dispute.juror1 = jurors.at(random_juror1_index);
-        new_dispute.juror2 = jurors.at(random_juror2_index);
-        new_dispute.juror3 = jurors.at(random_juror3_index);
+        new_dispute.jurors = jurors;
     });
 
     // Update handshake status.
     _handshakes.modify(existing_handshake, get_self(), [&](auto &handshake) {
-        handshake.status = DISPUTE;
+        set_status<CONFIRMATION, DISPUTE>(handshake);
     });
 }
 
-void dhsservice::motivate(eosio::name user, int32_t dhs_id, std::string motivation_hash)
+void dhsservice::motivate(eosio::name user, int32_t dhs_id, eosio::checksum256 motivation_hash)
 {
     // Ensure this action is authorized by the user.
     require_auth(user);
 
-    // Verify if the user is recorded as a user.
-    auto existing_user = _users.find(user.value);
-    check(existing_user != _users.end(), "motivate: USER NOT REGISTERED");
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("motivate");
 
-    // Verify handshake.
-    auto existing_handshake = _handshakes.find(dhs_id);
-
-    check(existing_handshake != _handshakes.end(), "motivate: HANDSHAKE NOT EXIST");
-    check(existing_handshake->status == DISPUTE, "motivate: HANDSHAKE NOT DISPUTE STATUS");
-
-    // Verify if the user is the dealer/bidder of the handshake.
-    check(existing_handshake->dealer == user || existing_handshake->bidder == user, "motivate: USER NOT HANDSHAKE PARTICIPANT");
+    // Verify user, handshake and if the user is the dealer/bidder of the handshake.
+    auto context = load_participant<DISPUTE, ANY_PARTICIPANT>(user, dhs_id, "motivate");
+    auto existing_handshake = context.handshake;
 
     // Verify other input data.
-    check(motivation_hash.length() == 64, "motivate: INVALID MOTIVATION HASH");
+    check(motivation_hash != eosio::checksum256(), "motivate: INVALID MOTIVATION HASH");
 
     // Verify dispute.
     auto existing_dispute = _disputes.find(dhs_id);
 
-    if (existing_handshake->dealer == user)
+    if (context.is_dealer)
     {
-        check(existing_dispute->dealer_motivation_hash.length() == 0, "motivate: DEALER ALREADY MOTIVATE");
+        check(existing_dispute->dealer_motivation_hash == eosio::checksum256(), "motivate: DEALER ALREADY MOTIVATE");
 
         // Update dispute.
         _disputes.modify(existing_dispute, get_self(), [&](auto &dispute) {
@@ -589,7 +877,7 @@ void dhsservice::motivate(eosio::name user, int32_t dhs_id, std::string motivati
     }
     else
     {
-        check(existing_dispute->bidder_motivation_hash.length() == 0, "motivate: BIDDER ALREADY MOTIVATE");
+        check(existing_dispute->bidder_motivation_hash == eosio::checksum256(), "motivate: BIDDER ALREADY MOTIVATE");
 
         // Update dispute.
         _disputes.modify(existing_dispute, get_self(), [&](auto &dispute) {
@@ -597,11 +885,11 @@ void dhsservice::motivate(eosio::name user, int32_t dhs_id, std::string motivati
         });
     }
 
-    if (existing_dispute->dealer_motivation_hash.length() == 64 && existing_dispute->bidder_motivation_hash.length() == 64)
+    if (existing_dispute->dealer_motivation_hash != eosio::checksum256() && existing_dispute->bidder_motivation_hash != eosio::checksum256())
     {
         // Update handshake status.
         _handshakes.modify(existing_handshake, get_self(), [&](auto &handshake) {
-            handshake.status = VOTING;
+            set_status<DISPUTE, VOTING>(handshake);
         });
     }
 }
@@ -611,6 +899,9 @@ void dhsservice::vote(eosio::name juror, int32_t dhs_id, eosio::name preference)
     // Ensure this action is authorized by the juror.
     require_auth(juror);
 
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("vote");
+
     // Verify if the user is recorded as a juror.
     auto existing_juror = _jurors.find(juror.value);
     check(existing_juror != _jurors.end(), "vote: JUROR NOT REGISTERED");
@@ -624,184 +915,470 @@ void dhsservice::vote(eosio::name juror, int32_t dhs_id, eosio::name preference)
     // Verify dispute.
     auto existing_dispute = _disputes.find(dhs_id);
 
+    // Find the position of the juror in the panel.
+    const auto &jurors = existing_dispute->jurors;
+    auto position = std::find(jurors.begin(), jurors.end(), juror);
+
     // Check if the juror has been designated for the handshake.
-    check(existing_dispute->juror1 == juror || existing_dispute->juror2 == juror || existing_dispute->juror3 == juror, "vote: NOT HANDSHAKE JUROR");
+    check(position != jurors.end(), "vote: NOT HANDSHAKE JUROR");
+
+    uint16_t juror_bit = 1 << (position - jurors.begin());
 
     // Check if the preference corresponds to the dealer or bidder of the handshake.
     check(existing_handshake->dealer == preference || existing_handshake->bidder == preference, "vote: NOT PREFERENCE FOR DEALER OR BIDDER");
 
-    if (existing_dispute->juror1 == juror)
+    // Check if the juror has already voted.
+    check((existing_dispute->voted & juror_bit) == 0, "vote: ALREADY VOTED");
+
+    uint16_t voted = existing_dispute->voted | juror_bit;
+    uint16_t votes_for_bidder = existing_dispute->votes_for_bidder | (preference == existing_handshake->bidder ? juror_bit : 0);
+
+    // Close the juror assignment.
+    close_assignment(juror, dhs_id);
+
+    // Update dispute.
+    _disputes.modify(existing_dispute, get_self(), [&](auto &dispute) {
+        dispute.voted = voted;
+        dispute.votes_for_bidder = votes_for_bidder;
+    });
+
+    // Token redistribution.
+    if (voted == (1 << jurors.size()) - 1)
     {
-        check(existing_dispute->vote1.to_string().length() == 0, "vote: ALREADY VOTED");
+        auto dealer = existing_handshake->dealer;
+        auto bidder = existing_handshake->bidder;
 
-        // Update dispute.
-        _disputes.modify(existing_dispute, get_self(), [&](auto &dispute) {
-            dispute.vote1 = preference;
+        // The majority of the panel decides the winner.
+        bool bidder_wins = __builtin_popcount(votes_for_bidder) * 2 > jurors.size();
+
+        auto existing_winner = _users.find(bidder_wins ? bidder.value : dealer.value);
+        auto existing_loser = _users.find(bidder_wins ? dealer.value : bidder.value);
+
+        // Update winner rating.
+        _users.modify(existing_winner, get_self(), [&](auto &winner) {
+            winner.rating += 1;
+        });
+
+        if (existing_loser->rating != 0)
+        {
+            // Update loser rating.
+            _users.modify(existing_loser, get_self(), [&](auto &loser) {
+                loser.rating -= 1;
+            });
+        }
+
+        // Winner: Dealer (0) or Bidder (1) - Redistribute the loser stake between the jurors.
+        // Inline unlock.
+        action{
+            permission_level{get_self(), "active"_n},
+            "dhsescrow"_n,
+            "resolved"_n,
+            std::make_tuple(get_self(), dhs_id, existing_handshake->price, jurors, uint8_t(bidder_wins ? 1 : 0))}
+            .send();
+
+        // Update handshake status.
+        _handshakes.modify(existing_handshake, get_self(), [&](auto &handshake) {
+            set_status<VOTING, RESOLVED>(handshake);
         });
     }
+}
+
+void dhsservice::setpanel(uint8_t panel_size)
+{
+    // Ensure the contract account authorized this action.
+    require_auth(get_self());
+
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("setpanel");
+
+    // Verify input data.
+    check(panel_size % 2 == 1 && panel_size <= max_panel_size, "setpanel: INVALID PANEL SIZE");
+
+    _panel_config.set(panel_config{panel_size}, get_self());
+}
+
+void dhsservice::setretention(uint32_t retention)
+{
+    // Ensure the contract account authorized this action.
+    require_auth(get_self());
+
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("setretention");
+
+    _retention.set(retention_config{retention}, get_self());
+}
+
+void dhsservice::archive(uint32_t max_rows)
+{
+    // Verify input data (no authorization required, anyone can pay for the archival).
+    check(max_rows > 0 && max_rows <= max_archive_rows, "archive: INVALID MAX ROWS");
 
-    if (existing_dispute->juror2 == juror)
+    // Verify that the rows of the previous contract version have been migrated.
+    require_migrated("archive");
+
+    auto handshakes_by_status = _handshakes.get_index<"bystatusdl"_n>();
+    uint64_t retention = _retention.get_or_default().retention;
+    uint32_t current_time = now();
+
+    // Visit the handshakes of every final status by deadline.
+    for (uint8_t status = ACCEPTED; status <= EXPIRED && max_rows > 0; status++)
     {
-        check(existing_dispute->vote2.to_string().length() == 0, "vote: ALREADY VOTED");
+        auto itr = handshakes_by_status.lower_bound(uint128_t(status) << 64);
 
-        // Update dispute.
-        _disputes.modify(existing_dispute, get_self(), [&](auto &dispute) {
-            dispute.vote2 = preference;
-        });
+        while (max_rows > 0 && itr != handshakes_by_status.end() && itr->status == status && itr->deadline + retention <= current_time)
+        {
+            // Move to the next handshake before the current one gets erased.
+            auto existing_handshake = itr++;
+
+            archive_handshake(existing_handshake->request_id, max_rows);
+        }
     }
+}
+
+void dhsservice::logarchive(archived_handshake /* summary */)
+{
+    // Only the contract notifies archived handshakes, the summary lives in the action traces.
+    require_auth(get_self());
+}
+
+/** HELPERS **/
+
+template <uint8_t Status, uint8_t Role>
+dhsservice::participant_context dhsservice::load_participant(eosio::name user, int32_t dhs_id, const char *action_name)
+{
+    static_assert(Status < dhs_status_count, "load_participant: INVALID STATUS");
 
-    if (existing_dispute->juror3 == juror)
+    auto existing_handshake = _handshakes.find(dhs_id);
+    bool found = existing_handshake != _handshakes.end();
+
+    bool is_dealer = found && existing_handshake->dealer == user;
+    bool is_bidder = found && existing_handshake->bidder == user;
+    bool is_participant = Role == DEALER_PARTICIPANT ? is_dealer : Role == BIDDER_PARTICIPANT ? is_bidder : is_dealer || is_bidder;
+
+    if (!found || existing_handshake->status != Status || !is_participant)
     {
-        check(existing_dispute->vote3.to_string().length() == 0, "vote: ALREADY VOTED");
+        // Report the first failing check, in the same order of the checks of every action.
+        std::string prefix = std::string(action_name) + ": ";
 
-        // Update dispute.
-        _disputes.modify(existing_dispute, get_self(), [&](auto &dispute) {
-            dispute.vote3 = preference;
-        });
+        check(_users.find(user.value) != _users.end(), prefix + "USER NOT REGISTERED");
+        check(found, prefix + "HANDSHAKE NOT EXIST");
+        check(existing_handshake->status == Status, prefix + "HANDSHAKE NOT " + dhs_status_names[Status] + " STATUS");
+        check(false, prefix + (Role == DEALER_PARTICIPANT ? "USER NOT HANDSHAKE DEALER" : Role == BIDDER_PARTICIPANT ? "USER NOT HANDSHAKE BIDDER" : "USER NOT HANDSHAKE PARTICIPANT"));
     }
 
-    // Token redistribution.
-    if (existing_dispute->vote1.to_string().length() > 0 && existing_dispute->vote2.to_string().length() > 0 && existing_dispute->vote3.to_string().length() > 0)
+    return participant_context{existing_handshake, is_dealer};
+}
+
+int32_t dhsservice::get_last_request_id()
+{
+    // The table is ordered by primary key, so the last row holds the highest identifier.
+    auto last_request = _requests.rbegin();
+
+    return last_request != _requests.rend() ? last_request->id : 0;
+}
+
+int32_t dhsservice::next_request_id()
+{
+    // Seed the counter from the requests table if it has never been stored.
+    request_counter counter = _request_counter.exists() ? _request_counter.get() : request_counter{get_last_request_id()};
+
+    counter.last_id += 1;
+    _request_counter.set(counter, get_self());
+
+    return counter.last_id;
+}
+
+void dhsservice::store_round(eosio::name payer, int32_t dhs_id, uint32_t round, const eosio::checksum256 &contractual_terms_hash, eosio::asset price, uint32_t deadline)
+{
+    _rounds.emplace(payer, [&](auto &new_round) {
+        new_round.dhs_id = dhs_id;
+        new_round.round = round;
+        new_round.contractual_terms_hash = contractual_terms_hash;
+        new_round.price = price;
+        new_round.deadline = deadline;
+    });
+}
+
+bool dhsservice::archive_handshake(int32_t dhs_id, uint32_t &budget)
+{
+    // Erase the negotiation history.
+    auto round_itr = _rounds.lower_bound(round_key(dhs_id, 0));
+
+    while (budget > 0 && round_itr != _rounds.end() && round_itr->dhs_id == dhs_id)
     {
-        auto dealer = existing_handshake->dealer;
-        auto bidder = existing_handshake->bidder;
+        round_itr = _rounds.erase(round_itr);
+        budget--;
+    }
 
-        auto existing_dealer = _users.find(dealer.value);
-        auto existing_bidder = _users.find(bidder.value);
+    // Erase the proposals of the related request.
+    auto proposals_by_request = _proposals.get_index<"byrequest"_n>();
+    auto proposal_itr = proposals_by_request.lower_bound(proposal_key(dhs_id, eosio::name()));
 
-        // Vector containing all jurors.
-        vector<eosio::name> jurors = {};
-        jurors.insert(jurors.begin(), existing_dispute->juror1);
-        jurors.insert(jurors.begin(), existing_dispute->juror2);
-        jurors.insert(jurors.begin(), existing_dispute->juror3);
+    while (budget > 0 && proposal_itr != proposals_by_request.end() && proposal_itr->request_id == dhs_id)
+    {
+        proposal_itr = proposals_by_request.erase(proposal_itr);
+        budget--;
+    }
 
-        if (existing_dispute->vote1 == existing_dispute->vote2 && existing_dispute->vote2 == existing_dispute->vote3)
-        {
+    // The handshake with its request and dispute rows counts as a single row.
+    if (budget == 0)
+        return false;
 
-            // Winner: Dealer - Redistribute 10 DHS tokens to every juror from bidder stake.
-            if (existing_dispute->vote1 == existing_handshake->dealer)
-            {
-                if (existing_bidder->rating != 0)
-                {
-                    // Update bidder rating
-                    _users.modify(existing_bidder, get_self(), [&](auto &bidder) {
-                        bidder.rating -= 1;
-                    });
-                }
-
-                // Update dealer rating
-                _users.modify(existing_dealer, get_self(), [&](auto &dealer) {
-                    dealer.rating += 1;
-                });
+    const auto &existing_handshake = _handshakes.get(dhs_id, "archive_handshake: HANDSHAKE NOT EXIST");
+    auto existing_dispute = _disputes.find(dhs_id);
+    auto existing_request = _requests.find(dhs_id);
 
-                // Inline unlock.
-                action{
-                    permission_level{get_self(), "active"_n},
-                    "dhsescrow"_n,
-                    "resolved"_n,
-                    std::make_tuple(get_self(), dealer, bidder, existing_handshake->price, jurors, 0)}
-                    .send();
-            }
-            else
-            {
-                // Update bidder rating
-                _users.modify(existing_bidder, get_self(), [&](auto &bidder) {
-                    bidder.rating += 1;
-                });
+    // Inline summary notification (the off-chain history keeps the handshake after the rows are gone).
+    action{
+        permission_level{get_self(), "active"_n},
+        get_self(),
+        "logarchive"_n,
+        std::make_tuple(archived_handshake{
+            dhs_id,
+            existing_handshake.dealer,
+            existing_handshake.bidder,
+            existing_handshake.price,
+            existing_handshake.deadline,
+            existing_handshake.contractual_terms_hash,
+            existing_handshake.status,
+            existing_handshake.rounds,
+            existing_dispute != _disputes.end()})}
+        .send();
 
-                if (existing_dealer->rating != 0)
-                {
-                    // Update dealer rating
-                    _users.modify(existing_dealer, get_self(), [&](auto &dealer) {
-                        dealer.rating -= 1;
-                    });
-                }
-
-                // Winner: Bidder - Redistribute 10 DHS tokens to every juror from dealer stake.
-                // Inline unlock.
-                action{
-                    permission_level{get_self(), "active"_n},
-                    "dhsescrow"_n,
-                    "resolved"_n,
-                    std::make_tuple(get_self(), dealer, bidder, existing_handshake->price, jurors, 1)}
-                    .send();
-            }
-        }
+    if (existing_dispute != _disputes.end())
+        _disputes.erase(existing_dispute);
+
+    if (existing_request != _requests.end())
+        _requests.erase(existing_request);
+
+    count_status(existing_handshake.status, NO_STATUS);
+
+    _handshakes.erase(existing_handshake);
+    budget--;
+
+    return true;
+}
+
+template <uint8_t From, uint8_t To>
+void dhsservice::set_status(digital_handshake &handshake)
+{
+    static_assert(is_valid_transition(From, To), "set_status: INVALID STATUS TRANSITION");
+
+    // The action has already verified the status of the handshake, this only guards against a wrong call site.
+    check(handshake.status == From, "set_status: INVALID STATUS TRANSITION");
+
+    handshake.status = To;
+    count_status(From, To);
+}
+
+void dhsservice::count_status(uint8_t from, uint8_t to, uint64_t count)
+{
+    auto &handshakes = get_stats().handshakes;
+
+    if (from != NO_STATUS)
+        handshakes[from] = handshakes[from] >= count ? handshakes[from] - count : 0;
+
+    if (to != NO_STATUS)
+        handshakes[to] += count;
+}
+
+dhsservice::service_stats &dhsservice::get_stats()
+{
+    if (!_stats.has_value())
+        _stats = _service_stats.get_or_default();
+
+    return *_stats;
+}
+
+eosio::checksum256 dhsservice::decode_hash(const std::string &hash)
+{
+    std::array<uint8_t, 32> bytes{};
+
+    if (hash.length() != 64)
+        return eosio::checksum256();
+
+    for (size_t i = 0; i < hash.length(); i++)
+    {
+        char c = hash[i];
+        uint8_t nibble;
+
+        if (c >= '0' && c <= '9')
+            nibble = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            nibble = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            nibble = c - 'A' + 10;
         else
-        {
-            if (
-                (existing_dispute->vote1 == existing_dispute->vote2 && existing_dispute->vote1 == existing_handshake->dealer) ||
-                (existing_dispute->vote2 == existing_dispute->vote3 && existing_dispute->vote2 == existing_handshake->dealer) ||
-                (existing_dispute->vote3 == existing_dispute->vote1 && existing_dispute->vote3 == existing_handshake->dealer))
-            {
-                // Winner: Dealer - Redistribute 10 DHS tokens to every juror from bidder stake.
-
-                if (existing_bidder->rating != 0)
-                {
-                    // Update bidder rating
-                    _users.modify(existing_bidder, get_self(), [&](auto &bidder) {
-                        bidder.rating -= 1;
-                    });
-                }
-
-                // Update dealer rating
-                _users.modify(existing_dealer, get_self(), [&](auto &dealer) {
-                    dealer.rating += 1;
-                });
+            return eosio::checksum256();
 
-                // Inline unlock.
-                action{
-                    permission_level{get_self(), "active"_n},
-                    "dhsescrow"_n,
-                    "resolved"_n,
-                    std::make_tuple(get_self(), dealer, bidder, existing_handshake->price, jurors, 0)}
-                    .send();
-            }
-            else
-            {
-                // Update bidder rating
-                _users.modify(existing_bidder, get_self(), [&](auto &bidder) {
-                    bidder.rating += 1;
-                });
+        bytes[i / 2] |= (i % 2 == 0) ? (nibble << 4) : nibble;
+    }
 
-                if (existing_dealer->rating != 0)
-                {
-                    // Update dealer rating
-                    _users.modify(existing_dealer, get_self(), [&](auto &dealer) {
-                        dealer.rating -= 1;
-                    });
-                }
-                
-                // Winner: Bidder - Redistribute 10 DHS tokens to every juror from dealer stake.
-                // Inline unlock.
-                action{
-                    permission_level{get_self(), "active"_n},
-                    "dhsescrow"_n,
-                    "resolved"_n,
-                    std::make_tuple(get_self(), dealer, bidder, existing_handshake->price, jurors, 1)}
-                    .send();
-            }
-        }
+    return eosio::checksum256(bytes);
+}
 
-        // Update handshake status.
-        _handshakes.modify(existing_handshake, get_self(), [&](auto &handshake) {
-            handshake.status = RESOLVED;
-        });
+template <eosio::name::raw TableName, typename LegacyRow, typename ChildWriter, typename Converter>
+bool dhsservice::migrate_rows(hash_migration &migration, uint32_t &budget, ChildWriter store_children, Converter convert)
+{
+    // Legacy view of the table (only the primary index is needed to read the rows).
+    eosio::multi_index<TableName, LegacyRow> legacy_table(get_self(), get_self().value);
+    auto itr = legacy_table.lower_bound(migration.cursor);
+
+    while (budget > 0 && itr != legacy_table.end())
+    {
+        // Store the child rows first, one budget unit each (when the budget runs out, the next call resumes from the next child).
+        migration.cursor = uint64_t(itr->primary_key());
+        migration.child = store_children(*itr, migration.child, budget);
+
+        if (budget == 0)
+            return false;
+
+        const std::vector<char> row = eosio::pack(convert(*itr));
+
+        // Rewrite the row in place with the same payer (the converter stores the entries of the secondary indexes).
+        int32_t db_itr = eosio::internal_use_do_not_use::db_find_i64(get_self().value, get_self().value, static_cast<uint64_t>(TableName), itr->primary_key());
+        eosio::internal_use_do_not_use::db_update_i64(db_itr, eosio::same_payer.value, row.data(), row.size());
+
+        migration.cursor += 1;
+        migration.child = 0;
+        budget--;
+        itr++;
     }
+
+    return itr == legacy_table.end();
 }
 
-/** HELPERS **/
+void dhsservice::store_secondary(eosio::name table, uint8_t index, uint64_t primary, uint64_t secondary)
+{
+    // The secondary indexes are stored in the table named after the table, with the index position in the lowest 4 bits.
+    eosio::internal_use_do_not_use::db_idx64_store(get_self().value, (table.value & 0xFFFFFFFFFFFFFFF0ULL) | index, get_self().value, primary, &secondary);
+}
 
-int32_t dhsservice::get_last_request_id()
+void dhsservice::store_secondary(eosio::name table, uint8_t index, uint64_t primary, uint128_t secondary)
+{
+    eosio::internal_use_do_not_use::db_idx128_store(get_self().value, (table.value & 0xFFFFFFFFFFFFFFF0ULL) | index, get_self().value, primary, &secondary);
+}
+
+void dhsservice::remove_secondary(eosio::name table, uint8_t index, uint64_t primary)
+{
+    uint64_t secondary = 0;
+    int32_t itr = eosio::internal_use_do_not_use::db_idx64_find_primary(get_self().value, get_self().value, (table.value & 0xFFFFFFFFFFFFFFF0ULL) | index, &secondary, primary);
+
+    if (itr >= 0)
+        eosio::internal_use_do_not_use::db_idx64_remove(itr);
+}
+
+void dhsservice::require_migrated(const char *action_name)
 {
-    int32_t last_id = 0;
+    if (_hash_migration.exists())
+    {
+        if (_hash_migration.get().step != MIGRATION_DONE)
+            check(false, std::string(action_name) + ": MIGRATION PENDING");
+
+        return;
+    }
+
+    // No migration progress: the contract has been deployed fresh (nothing to migrate) or upgraded and not migrated yet.
+    if (has_stored_rows())
+        check(false, std::string(action_name) + ": MIGRATION PENDING");
 
-    for (auto itr = _requests.begin(); itr != _requests.end(); itr++)
+    _hash_migration.set(hash_migration{MIGRATION_DONE}, get_self());
+}
+
+bool dhsservice::has_stored_rows()
+{
+    // The rows are looked up through the raw database API, the legacy rows cannot be read with the current layouts.
+    for (eosio::name table : {"users"_n, "jurors"_n, "requests"_n, "handshakes"_n, "negotiations"_n, "disputes"_n})
     {
-        last_id = itr->id;
+        if (eosio::internal_use_do_not_use::db_lowerbound_i64(get_self().value, get_self().value, table.value, 0) >= 0)
+            return true;
     }
 
-    return last_id;
+    return false;
+}
+
+void dhsservice::add_assignment(eosio::name payer, eosio::name juror, int32_t dhs_id)
+{
+    _assignments.emplace(payer, [&](auto &new_assignment) {
+        new_assignment.id = _assignments.available_primary_key();
+        new_assignment.juror = juror;
+        new_assignment.dhs_id = dhs_id;
+    });
+
+    // Update the juror load (jurors not yet in the pool have no slot to track it).
+    auto slots_by_juror = _juror_slots.get_index<"byjuror"_n>();
+    auto juror_slot = slots_by_juror.find(juror.value);
+
+    if (juror_slot != slots_by_juror.end())
+        slots_by_juror.modify(juror_slot, get_self(), [&](auto &slot) {
+            slot.load += 1;
+        });
+}
+
+void dhsservice::close_assignment(eosio::name juror, int32_t dhs_id)
+{
+    auto assignments_by_juror = _assignments.get_index<"byjuror"_n>();
+    auto assignment = assignments_by_juror.find((uint128_t(juror.value) << 64) | uint32_t(dhs_id));
+
+    check(assignment != assignments_by_juror.end(), "close_assignment: ASSIGNMENT NOT EXIST");
+    assignments_by_juror.erase(assignment);
+
+    // Update the juror load.
+    auto slots_by_juror = _juror_slots.get_index<"byjuror"_n>();
+    auto juror_slot = slots_by_juror.find(juror.value);
+
+    if (juror_slot != slots_by_juror.end() && juror_slot->load > 0)
+        slots_by_juror.modify(juror_slot, get_self(), [&](auto &slot) {
+            slot.load -= 1;
+        });
+}
+
+const char *dhsservice::try_propose(eosio::name bidder, int32_t request_id)
+{
+    // Verify request.
+    auto existing_request = _requests.find(request_id);
+
+    if (existing_request == _requests.end())
+        return "REQUEST NOT POSTED";
+    if (existing_request->status != OPEN)
+        return "REQUEST NOT OPEN";
+    if (existing_request->dealer == bidder)
+        return "REQUEST DEALER CANNOT PROPOSE";
+
+    // Verify if the bidder has already proposed for the request.
+    auto proposals_by_request = _proposals.get_index<"byrequest"_n>();
+
+    if (proposals_by_request.find(proposal_key(request_id, bidder)) != proposals_by_request.end())
+        return "USER ALREADY PROPOSED";
+
+    // Store the proposal.
+    _proposals.emplace(bidder, [&](auto &new_proposal) {
+        new_proposal.id = _proposals.available_primary_key();
+        new_proposal.request_id = request_id;
+        new_proposal.bidder = bidder;
+    });
+
+    return nullptr;
+}
+
+bool dhsservice::parse_dhs_id(const std::string &memo, int32_t &dhs_id)
+{
+    // At most 9 digits, so the value always fits an int32_t.
+    if (memo.empty() || memo.length() > 9)
+        return false;
+
+    int32_t value = 0;
+
+    for (char c : memo)
+    {
+        if (c < '0' || c > '9')
+            return false;
+
+        value = value * 10 + (c - '0');
+    }
+
+    dhs_id = value;
+    return true;
 }
 
 uint32_t dhsservice::now()
@@ -813,46 +1390,126 @@ asset dhsservice::get_user_balance(name user)
 {
     accounts from_acnts("dhstoken"_n, user.value);
 
-    const auto &from = from_acnts.get(dhs_symbol.code().raw(), "get_user_balance: NO DHS TOKEN BALANCE FOUND");
+    const auto &from = from_acnts.get(dhs::token_symbol.code().raw(), "get_user_balance: NO DHS TOKEN BALANCE FOUND");
 
     return from.balance;
 }
 
-vector<eosio::name> dhsservice::get_jurors()
+void dhsservice::add_pool_juror(eosio::name juror)
 {
-    vector<eosio::name> jurors = {};
+    juror_pool pool = _juror_pool.get_or_default();
+
+    // Store the juror in the first free slot.
+    _juror_slots.emplace(get_self(), [&](auto &new_slot) {
+        new_slot.slot = pool.size;
+        new_slot.juror = juror;
+    });
+
+    pool.size += 1;
+    _juror_pool.set(pool, get_self());
+}
+
+void dhsservice::remove_pool_juror(eosio::name juror)
+{
+    juror_pool pool = _juror_pool.get_or_default();
+    check(pool.size > 0, "remove_pool_juror: EMPTY JUROR POOL");
+
+    auto slots_by_juror = _juror_slots.get_index<"byjuror"_n>();
+    auto juror_slot = slots_by_juror.find(juror.value);
+    check(juror_slot != slots_by_juror.end(), "remove_pool_juror: JUROR NOT IN POOL");
+
+    auto last_slot = _juror_slots.find(pool.size - 1);
+    check(last_slot != _juror_slots.end(), "remove_pool_juror: INVALID JUROR SLOT");
 
-    for (auto itr = _jurors.begin(); itr != _jurors.end(); itr++)
+    if (juror_slot->slot != last_slot->slot)
     {
-        jurors.insert(jurors.begin(), itr->info.username);
+        // Move the juror of the last slot into the freed slot to keep the pool dense.
+        _juror_slots.modify(_juror_slots.iterator_to(*juror_slot), get_self(), [&](auto &slot) {
+            slot.juror = last_slot->juror;
+            slot.load = last_slot->load;
+        });
     }
 
-    return jurors;
+    _juror_slots.erase(last_slot);
+
+    pool.size -= 1;
+    _juror_pool.set(pool, get_self());
 }
 
-// Simple Pseudo Random Number Algorithm, randomly pick a number within 0 to n-1
-int dhsservice::random(const int range)
+const dhsservice::juror_slot &dhsservice::get_pool_slot(uint64_t slot)
 {
-    // Find the existing seed
+    return _juror_slots.get(slot, "get_pool_slot: INVALID JUROR SLOT");
+}
+
+std::vector<uint64_t> dhsservice::draw_jurors(uint64_t count, uint64_t pool_size)
+{
+    // Find the existing seed.
     auto seed_iterator = _seed.begin();
 
-    // Initialize the seed with default value if it is not found
-    if (seed_iterator == _seed.end())
-    {
-        seed_iterator = _seed.emplace(_self, [&](auto &seed) {});
-    }
+    // Entropy: the transaction (whose hash is the transaction id), the TaPoS block prefix and the stored seed.
+    size_t tx_size = transaction_size();
+    std::vector<char> entropy(tx_size + 2 * sizeof(uint32_t));
+    uint32_t block_prefix = tapos_block_prefix();
+    uint32_t seed_value = seed_iterator != _seed.end() ? seed_iterator->value : 1;
 
-    // Generate new seed value using the existing seed value
-    int prime = 65537;
-    auto new_seed_value = (seed_iterator->value + current_time_point().elapsed.count()) % prime;
+    read_transaction(entropy.data(), tx_size);
+    memcpy(entropy.data() + tx_size, &block_prefix, sizeof(uint32_t));
+    memcpy(entropy.data() + tx_size + sizeof(uint32_t), &seed_value, sizeof(uint32_t));
 
-    // Store the updated seed value in the table
-    _seed.modify(seed_iterator, _self, [&](auto &s) {
-        s.value = new_seed_value;
-    });
+    auto digest = sha256(entropy.data(), entropy.size()).extract_as_byte_array();
+    size_t digest_offset = 0;
+
+    // Helper to read the next 32 bits of the digest (hashing the digest again when every word has been used).
+    auto next_word = [&]() {
+        if (digest_offset == digest.size())
+        {
+            digest = sha256(reinterpret_cast<const char *>(digest.data()), digest.size()).extract_as_byte_array();
+            digest_offset = 0;
+        }
+
+        uint32_t word;
+        memcpy(&word, digest.data() + digest_offset, sizeof(uint32_t));
+        digest_offset += sizeof(uint32_t);
 
-    // Get the random result in desired range
-    int random_result = new_seed_value % range;
+        return word;
+    };
+
+    // Partial Fisher-Yates shuffle of the slots: only the positions moved by a swap are stored.
+    std::vector<std::pair<uint64_t, uint64_t>> moved;
+    auto slot_at = [&](uint64_t position) {
+        for (const auto &entry : moved)
+            if (entry.first == position)
+                return entry.second;
+
+        return position;
+    };
+
+    std::vector<uint64_t> slots;
+    for (uint64_t i = 0; i < count; i++)
+    {
+        uint64_t j = i + next_word() % (pool_size - i);
+        uint64_t picked = slot_at(j);
+
+        // Position i is never drawn again, so only position j keeps the slot it gets from the swap.
+        uint64_t swapped = slot_at(i);
+        auto entry = std::find_if(moved.begin(), moved.end(), [&](const auto &e) { return e.first == j; });
+        if (entry != moved.end())
+            entry->second = swapped;
+        else
+            moved.emplace_back(j, swapped);
+
+        slots.push_back(picked);
+    }
+
+    // Store the next seed value (the only state write of the draw).
+    if (seed_iterator == _seed.end())
+        _seed.emplace(get_self(), [&](auto &seed) {
+            seed.value = next_word();
+        });
+    else
+        _seed.modify(seed_iterator, get_self(), [&](auto &seed) {
+            seed.value = next_word();
+        });
 
-    return random_result;
+    return slots;
 }
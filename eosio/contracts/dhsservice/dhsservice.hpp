@@ -3,7 +3,12 @@
 #include <eosio/asset.hpp>
 #include <eosio/system.hpp>
 #include <eosio/symbol.hpp>
+#include <eosio/crypto.hpp>
+#include <eosio/transaction.hpp>
+#include <eosio/singleton.hpp>
+#include <optional>
 #include "dhstoken.hpp"
+#include "../common/dhsconfig.hpp"
 using namespace std;
 using namespace eosio;
 
@@ -18,8 +23,14 @@ using namespace eosio;
 class [[eosio::contract]] dhsservice : public eosio::contract
 {
 private:
-    const symbol dhs_symbol;        // The DHS token symbol.
-    const eosio::asset fixed_stake; // The fixed price for the amount of stake necessary for every digital handshake.
+    static constexpr uint32_t max_sweep_rows = 50;                   // The maximum number of handshakes expired by a single sweep.
+    static constexpr uint32_t max_archive_rows = 100;                // The maximum number of rows erased by a single archive call.
+    static constexpr uint32_t default_retention = 30 * 24 * 60 * 60; // The default seconds a finished handshake is kept after its deadline.
+    static constexpr uint8_t default_panel_size = 3;                 // The default number of jurors drawn for a dispute.
+    static constexpr uint8_t max_panel_size = 15;                    // The maximum number of jurors drawn for a dispute (one bit each in the vote masks).
+    static constexpr uint32_t max_juror_load = 5;                    // The open assignments above which a juror is skipped by the draw.
+    static constexpr uint8_t draws_per_seat = 4;                     // The candidates drawn for each seat of the panel (to replace the overloaded jurors).
+    static constexpr uint32_t max_batch_proposals = 20;              // The maximum number of requests of a batch proposal.
 
     // List of values for the different possible roles for the user.
     enum user_role : uint8_t
@@ -49,11 +60,44 @@ private:
         EXPIRED = 8,
     };
 
+    static constexpr uint8_t dhs_status_count = EXPIRED + 1; // The number of digital handshake status.
+    static constexpr uint8_t NO_STATUS = 0xFF;                // Placeholder status of a digital handshake not stored yet (or already erased).
+
+    // Lifecycle transition table: bit `to` of the entry `from` is set when a digital handshake can move from `from` to `to`.
+    static constexpr uint16_t dhs_transitions[dhs_status_count] = {
+        1 << LOCK,                        // NEGOTIATION -> LOCK.
+        1 << EXECUTION,                   // LOCK -> EXECUTION.
+        1 << CONFIRMATION | 1 << EXPIRED, // EXECUTION -> CONFIRMATION or EXPIRED.
+        1 << ACCEPTED | 1 << DISPUTE,     // CONFIRMATION -> ACCEPTED or DISPUTE.
+        1 << VOTING,                      // DISPUTE -> VOTING.
+        1 << RESOLVED,                    // VOTING -> RESOLVED.
+        0,                                // ACCEPTED (final).
+        0,                                // RESOLVED (final).
+        0                                 // EXPIRED (final).
+    };
+
+    // Helper to check if the transition table allows a digital handshake to move from a status to another one.
+    static constexpr bool is_valid_transition(uint8_t from, uint8_t to)
+    {
+        return from < dhs_status_count && to < dhs_status_count && (dhs_transitions[from] >> to & 1) == 1;
+    }
+
+    // Names of the digital handshake status (indexed by `dhs_status`, used only to report failures).
+    static constexpr const char *dhs_status_names[] = {"NEGOTIATION", "LOCK", "EXECUTION", "CONFIRMATION", "DISPUTE", "VOTING", "ACCEPTED", "RESOLVED", "EXPIRED"};
+
+    // List of values for the handshake participant an action must be performed by.
+    enum participant_role : uint8_t
+    {
+        ANY_PARTICIPANT = 0,
+        DEALER_PARTICIPANT = 1,
+        BIDDER_PARTICIPANT = 2
+    };
+
     // Shared users information.
     struct shared_info
     {
-        eosio::name username;           // Eosio account name.
-        std::string external_data_hash; // SHA256 of external personal data (e.g., name, surname, ...).
+        eosio::name username;                  // Eosio account name.
+        eosio::checksum256 external_data_hash; // SHA256 of external personal data (e.g., name, surname, ...).
     };
 
     struct [[eosio::table]] user
@@ -62,6 +106,8 @@ private:
         uint64_t rating; // Evaluation of the work goodness.
 
         auto primary_key() const { return info.username.value; }
+        // Composite key (rating, username) keeps the key unique, the leaderboard is the index read in reverse order.
+        uint128_t rating_secondary() const { return rating_key(rating, info.username); }
     };
 
     struct [[eosio::table]] juror
@@ -73,66 +119,91 @@ private:
 
     struct [[eosio::table]] request
     {
-        int32_t id;                         // Unique identifiers.
-        eosio::name dealer;                 // The dealer username (who makes the request).
-        std::string summary;                // The short summary of the request.
-        std::string contractual_terms_hash; // SHA256 of the contractual terms proposal (e.g., file urls, contract object, ...).
-        eosio::asset price;                 // The ideal amount to pay.
-        uint32_t deadline;                  // The ideal deadline to satisfy the request.
-        uint8_t status;                     // The status of the request.
-        vector<eosio::name> bidders;        // The list of users who propose for the request.
-        eosio::name bidder;                 // The user selected from the bidders list by the dealer.
+        int32_t id;                                // Unique identifiers.
+        eosio::name dealer;                        // The dealer username (who makes the request).
+        std::string summary;                       // The short summary of the request.
+        eosio::checksum256 contractual_terms_hash; // SHA256 of the contractual terms proposal (e.g., file urls, contract object, ...).
+        eosio::asset price;                        // The ideal amount to pay.
+        uint32_t deadline;                         // The ideal deadline to satisfy the request.
+        uint8_t status;                            // The status of the request.
+        eosio::name bidder;                        // The user selected from the bidders by the dealer.
+
+        auto primary_key() const { return id; }
+        // Composite keys (field, id) keep the secondary keys unique, so results can be paged from the last returned key.
+        uint64_t status_secondary() const { return (uint64_t(status) << 32) | uint32_t(id); }
+        uint128_t dealer_secondary() const { return (uint128_t(dealer.value) << 64) | uint32_t(id); }
+        uint64_t deadline_secondary() const { return (uint64_t(deadline) << 32) | uint32_t(id); }
+    };
+
+    struct [[eosio::table]] proposal
+    {
+        uint64_t id;        // Unique identifier.
+        int32_t request_id; // Unique identifier of the related request.
+        eosio::name bidder; // The user who proposes for the request.
 
         auto primary_key() const { return id; }
+        uint128_t request_secondary() const { return proposal_key(request_id, bidder); }
+        uint128_t bidder_secondary() const { return (uint128_t(bidder.value) << 64) | uint32_t(request_id); }
     };
 
+    // A digital handshake with its current terms (the last proposal while in NEGOTIATION status, the agreed ones afterwards).
     struct [[eosio::table]] digital_handshake
     {
-        int32_t request_id;                   // Unique identifier of the related request.
-        eosio::name dealer;                   // The dealer username.
-        eosio::name bidder;                   // The bidder username.
-        eosio::asset price;                   // The amount to pay.
-        uint32_t deadline;                    // The deadline.
-        std::string contractual_terms_hash;   // SHA256 of the contractual terms proposal (e.g., file urls, contract object, ...).
-        uint8_t status;                       // The current status of the digital handshake.
-        bool unlock_for_expiration_by_dealer; // True when the dealer has unlocked the tokens after deadline expiration.
-        bool unlock_for_expiration_by_bidder; // True when the bidder has unlocked the tokens after deadline expiration.
+        int32_t request_id;                        // Unique identifier of the related request.
+        eosio::name dealer;                        // The dealer username.
+        eosio::name bidder;                        // The bidder username.
+        eosio::asset price;                        // The amount to pay.
+        uint32_t deadline;                         // The deadline.
+        eosio::checksum256 contractual_terms_hash; // SHA256 of the contractual terms proposal (e.g., file urls, contract object, ...).
+        uint8_t status;                            // The current status of the digital handshake.
+        uint32_t rounds;                           // The number of proposals made so far (the first one copies the request terms).
+        bool accepted_by_dealer;                   // True when the dealer accepts the current contractual terms.
+        bool accepted_by_bidder;                   // True when the bidder accepts the current contractual terms.
+        bool lock_by_dealer;                       // True when the dealer has locked the tokens.
+        bool lock_by_bidder;                       // True when the bidder has locked the tokens.
+        bool unlock_for_expiration_by_dealer;      // True when the dealer has unlocked the tokens after deadline expiration.
+        bool unlock_for_expiration_by_bidder;      // True when the bidder has unlocked the tokens after deadline expiration.
 
         auto primary_key() const { return request_id; }
+        uint128_t dealer_secondary() const { return (uint128_t(dealer.value) << 64) | uint32_t(request_id); }
+        uint128_t bidder_secondary() const { return (uint128_t(bidder.value) << 64) | uint32_t(request_id); }
+        uint128_t status_deadline_secondary() const { return (uint128_t(status) << 64) | (uint64_t(deadline) << 32) | uint32_t(request_id); }
     };
 
-    struct [[eosio::table]] contractual_terms_proposal
+    struct [[eosio::table]] negotiation_round
     {
-        int32_t dhs_id;                                        // Unique identifier of the related digital handshake.
-        vector<std::string> proposed_contractual_terms_hashes; // SHA256 of the contractual terms proposals (e.g., file urls, contract object, ...).
-        vector<eosio::asset> proposed_prices;                  // The ideal amounts to pay.
-        vector<uint32_t> proposed_deadlines;                   // The ideal deadlines to satisfy the request.
-        bool accepted_by_dealer;                               // True when the dealer accepts the last proposed contractual terms.
-        bool accepted_by_bidder;                               // True when the bidder accepts the last proposed contractual terms.
-        bool lock_by_dealer;                                   // True when the dealer has locked the tokens.
-        bool lock_by_bidder;                                   // True when the bidder has locked the tokens.
+        int32_t dhs_id;                            // Unique identifier of the related digital handshake.
+        uint32_t round;                            // Position of the proposal in the negotiation (0 for the request terms).
+        eosio::checksum256 contractual_terms_hash; // SHA256 of the proposed contractual terms (e.g., file urls, contract object, ...).
+        eosio::asset price;                        // The proposed amount to pay.
+        uint32_t deadline;                         // The proposed deadline to satisfy the request.
 
-        auto primary_key() const { return dhs_id; }
+        auto primary_key() const { return round_key(dhs_id, round); }
     };
 
     struct [[eosio::table]] dispute
     {
-        int32_t dhs_id;                     // Unique identifier of the related digital handshake.
-        eosio::name dealer;                 // The dealer username.
-        eosio::name bidder;                 // The bidder username.
-        eosio::name juror1;                 // The account name of the first random picked juror for the dispute.
-        eosio::name juror2;                 // The account name of the second random picked juror for the dispute.
-        eosio::name juror3;                 // The account name of the third random picked juror for the dispute.
-        eosio::name vote1;                  // The hash of the vote of the first juror.
-        eosio::name vote2;                  // The hash of the vote of the second juror.
-        eosio::name vote3;                  // The hash of the vote of the third juror.
-        std::string dealer_motivation_hash; // The hash of the explanation for the dispute for the dealer.
-        std::string bidder_motivation_hash; // The hash of the explanation for the dispute for the bidder.
+        int32_t dhs_id;                            // Unique identifier of the related digital handshake.
+        eosio::name dealer;                        // The dealer username.
+        eosio::name bidder;                        // The bidder username.
+        std::vector<eosio::name> jurors;           // The account names of the random picked jurors for the dispute (the panel).
+        uint16_t voted;                            // Bit i is set when the juror in position i of the panel has voted.
+        uint16_t votes_for_bidder;                 // Bit i is set when the juror in position i of the panel has voted for the bidder.
+        eosio::checksum256 dealer_motivation_hash; // The hash of the explanation for the dispute for the dealer.
+        eosio::checksum256 bidder_motivation_hash; // The hash of the explanation for the dispute for the bidder.
 
         auto primary_key() const { return dhs_id; }
-        uint64_t juror1_secondary() const { return juror1.value; }
-        uint64_t juror2_secondary() const { return juror2.value; }
-        uint64_t juror3_secondary() const { return juror3.value; }
+    };
+
+    // A juror of the panel of a dispute who has not voted yet.
+    struct [[eosio::table]] juror_assignment
+    {
+        uint64_t id;       // Unique identifier.
+        eosio::name juror; // The juror username.
+        int32_t dhs_id;    // Unique identifier of the disputed digital handshake.
+
+        auto primary_key() const { return id; }
+        uint128_t juror_secondary() const { return (uint128_t(juror.value) << 64) | uint32_t(dhs_id); }
     };
 
     struct [[eosio::table]] seed
@@ -143,44 +214,323 @@ private:
         auto primary_key() const { return key; }
     };
 
-    typedef eosio::multi_index<"users"_n, user>
+    // Dense index of the registered jurors (slot -> juror), kept compact so the juror draw reads only the picked rows.
+    struct [[eosio::table]] juror_slot
+    {
+        uint64_t slot;     // Position of the juror in the pool (from 0 to pool size - 1).
+        eosio::name juror; // The juror username.
+        uint32_t load = 0; // The number of open assignments (disputes waiting for the juror vote).
+
+        auto primary_key() const { return slot; }
+        uint64_t juror_secondary() const { return juror.value; }
+    };
+
+    // Number of jurors in the dense juror pool.
+    struct [[eosio::table]] juror_pool
+    {
+        uint64_t size = 0; // The number of occupied slots.
+    };
+
+    // Persisted counter for the requests primary key (avoids walking the requests table on every post).
+    struct [[eosio::table]] request_counter
+    {
+        int32_t last_id = 0; // The identifier assigned to the last posted request.
+    };
+
+    // Number of jurors drawn for a new dispute.
+    struct [[eosio::table]] panel_config
+    {
+        uint8_t size = default_panel_size; // The panel size (odd, so the votes always have a majority).
+    };
+
+    // Service statistics for dashboards, updated incrementally by the actions (the open disputes are the handshakes in DISPUTE or VOTING status).
+    struct [[eosio::table]] service_stats
+    {
+        uint64_t users = 0;                                                             // The number of registered users.
+        uint64_t jurors = 0;                                                            // The number of registered jurors.
+        uint64_t open_requests = 0;                                                     // The number of requests in OPEN status.
+        std::vector<uint64_t> handshakes = std::vector<uint64_t>(dhs_status_count, 0); // The number of digital handshakes (indexed by `dhs_status`).
+    };
+
+    // Retention window for finished handshakes (ACCEPTED, RESOLVED or EXPIRED) before they can be archived.
+    struct [[eosio::table]] retention_config
+    {
+        uint32_t retention = default_retention; // Seconds after the deadline during which the handshake rows are kept.
+    };
+
+    // Compact summary of an archived digital handshake, emitted through the `logarchive` action before the rows get erased.
+    struct archived_handshake
+    {
+        int32_t dhs_id;                            // Unique identifier of the digital handshake (and of the related request).
+        eosio::name dealer;                        // The dealer username.
+        eosio::name bidder;                        // The bidder username.
+        eosio::asset price;                        // The agreed amount to pay.
+        uint32_t deadline;                         // The agreed deadline.
+        eosio::checksum256 contractual_terms_hash; // SHA256 of the agreed contractual terms.
+        uint8_t status;                            // The final status of the digital handshake.
+        uint32_t rounds;                           // The number of negotiation proposals.
+        bool disputed;                             // True when the digital handshake went through a dispute.
+    };
+
+    // A request of a batch proposal which has not been proposed, emitted through the `logbatch` action.
+    struct batch_failure
+    {
+        int32_t request_id; // The identifier of the request.
+        std::string reason; // The reason of the failure (the `propose` error message).
+    };
+
+    // List of the tables rewritten, in order, by the hash migration.
+    enum hash_migration_step : uint8_t
+    {
+        MIGRATE_USERS = 0,
+        MIGRATE_JURORS = 1,
+        MIGRATE_REQUESTS = 2,
+        MIGRATE_HANDSHAKES = 3, // The negotiations rows are folded into the handshakes rows.
+        MIGRATE_DISPUTES = 4,
+        MIGRATION_DONE = 5
+    };
+
+    // Progress of the migration of the rows which store the hashes as hex strings.
+    struct [[eosio::table]] hash_migration
+    {
+        uint8_t step = MIGRATE_USERS; // The table under migration.
+        uint64_t cursor = 0;          // The primary key where the migration of the table resumes.
+        uint32_t child = 0;           // The child rows of the row at `cursor` already stored (the row is rewritten after its last child).
+    };
+
+    // Row layouts written by the previous contract version, field by field (read only by the `migratehash` action).
+    struct legacy_shared_info
+    {
+        eosio::name username;
+        std::string external_data_hash;
+    };
+
+    struct legacy_user
+    {
+        legacy_shared_info info;
+        uint64_t rating;
+
+        auto primary_key() const { return info.username.value; }
+    };
+
+    struct legacy_juror
+    {
+        legacy_shared_info info;
+
+        auto primary_key() const { return info.username.value; }
+    };
+
+    struct legacy_request
+    {
+        int32_t id;
+        eosio::name dealer;
+        std::string summary;
+        std::string contractual_terms_hash;
+        eosio::asset price;
+        uint32_t deadline;
+        uint8_t status;
+        std::vector<eosio::name> bidders;
+        eosio::name bidder;
+
+        auto primary_key() const { return id; }
+    };
+
+    struct legacy_digital_handshake
+    {
+        int32_t request_id;
+        eosio::name dealer;
+        eosio::name bidder;
+        eosio::asset price;
+        uint32_t deadline;
+        std::string contractual_terms_hash;
+        uint8_t status;
+        bool unlock_for_expiration_by_dealer;
+        bool unlock_for_expiration_by_bidder;
+
+        auto primary_key() const { return request_id; }
+    };
+
+    struct legacy_contractual_terms_proposal
+    {
+        int32_t dhs_id;
+        std::vector<std::string> proposed_contractual_terms_hashes;
+        std::vector<eosio::asset> proposed_prices;
+        std::vector<uint32_t> proposed_deadlines;
+        bool accepted_by_dealer;
+        bool accepted_by_bidder;
+        bool lock_by_dealer;
+        bool lock_by_bidder;
+
+        auto primary_key() const { return dhs_id; }
+    };
+
+    struct legacy_dispute
+    {
+        int32_t dhs_id;
+        eosio::name dealer;
+        eosio::name bidder;
+        eosio::name juror1;
+        eosio::name juror2;
+        eosio::name juror3;
+        eosio::name vote1;
+        eosio::name vote2;
+        eosio::name vote3;
+        std::string dealer_motivation_hash;
+        std::string bidder_motivation_hash;
+
+        auto primary_key() const { return dhs_id; }
+    };
+
+    typedef eosio::multi_index<"users"_n, user,
+                               eosio::indexed_by<"byrating"_n, eosio::const_mem_fun<user, uint128_t, &user::rating_secondary>>>
         users_table;
     typedef eosio::multi_index<"jurors"_n, juror>
         jurors_table;
-    typedef eosio::multi_index<"requests"_n, request> requests_table;
-    typedef eosio::multi_index<"negotiations"_n, contractual_terms_proposal> negotiations_table;
-    typedef eosio::multi_index<"handshakes"_n, digital_handshake> digital_handshakes_table;
-    typedef eosio::multi_index<"disputes"_n, dispute,
-                               eosio::indexed_by<"j1secid"_n, eosio::const_mem_fun<dispute, uint64_t, &dispute::juror1_secondary>>,
-                               eosio::indexed_by<"j2secid"_n, eosio::const_mem_fun<dispute, uint64_t, &dispute::juror2_secondary>>,
-                               eosio::indexed_by<"j3secid"_n, eosio::const_mem_fun<dispute, uint64_t, &dispute::juror3_secondary>>>
-        disputes_table;
+    typedef eosio::multi_index<"requests"_n, request,
+                               eosio::indexed_by<"bystatus"_n, eosio::const_mem_fun<request, uint64_t, &request::status_secondary>>,
+                               eosio::indexed_by<"bydealer"_n, eosio::const_mem_fun<request, uint128_t, &request::dealer_secondary>>,
+                               eosio::indexed_by<"bydeadline"_n, eosio::const_mem_fun<request, uint64_t, &request::deadline_secondary>>>
+        requests_table;
+    typedef eosio::multi_index<"proposals"_n, proposal,
+                               eosio::indexed_by<"byrequest"_n, eosio::const_mem_fun<proposal, uint128_t, &proposal::request_secondary>>,
+                               eosio::indexed_by<"bybidder"_n, eosio::const_mem_fun<proposal, uint128_t, &proposal::bidder_secondary>>>
+        proposals_table;
+    typedef eosio::multi_index<"rounds"_n, negotiation_round> rounds_table;
+    typedef eosio::multi_index<"negotiations"_n, legacy_contractual_terms_proposal> legacy_negotiations_table; // Read only by the `migratehash` action.
+    typedef eosio::multi_index<"handshakes"_n, digital_handshake,
+                               eosio::indexed_by<"bydealer"_n, eosio::const_mem_fun<digital_handshake, uint128_t, &digital_handshake::dealer_secondary>>,
+                               eosio::indexed_by<"bybidder"_n, eosio::const_mem_fun<digital_handshake, uint128_t, &digital_handshake::bidder_secondary>>,
+                               eosio::indexed_by<"bystatusdl"_n, eosio::const_mem_fun<digital_handshake, uint128_t, &digital_handshake::status_deadline_secondary>>>
+        digital_handshakes_table;
+    typedef eosio::multi_index<"disputes"_n, dispute> disputes_table;
+    typedef eosio::multi_index<"assignments"_n, juror_assignment,
+                               eosio::indexed_by<"byjuror"_n, eosio::const_mem_fun<juror_assignment, uint128_t, &juror_assignment::juror_secondary>>>
+        assignments_table;
     typedef eosio::multi_index<"seed"_n, seed> seed_table;
+    typedef eosio::singleton<"reqcounter"_n, request_counter> request_counter_singleton;
+    typedef eosio::multi_index<"jurorslots"_n, juror_slot,
+                               eosio::indexed_by<"byjuror"_n, eosio::const_mem_fun<juror_slot, uint64_t, &juror_slot::juror_secondary>>>
+        juror_slots_table;
+    typedef eosio::singleton<"jurorpool"_n, juror_pool> juror_pool_singleton;
+    typedef eosio::singleton<"retention"_n, retention_config> retention_singleton;
+    typedef eosio::singleton<"panelconf"_n, panel_config> panel_config_singleton;
+    typedef eosio::singleton<"hashmigr"_n, hash_migration> hash_migration_singleton;
+    typedef eosio::singleton<"stats"_n, service_stats> service_stats_singleton;
 
     users_table _users;
     jurors_table _jurors;
     requests_table _requests;
-    negotiations_table _negotiations;
+    proposals_table _proposals;
+    rounds_table _rounds;
     digital_handshakes_table _handshakes;
     disputes_table _disputes;
+    assignments_table _assignments;
     seed_table _seed;
+    request_counter_singleton _request_counter;
+    juror_slots_table _juror_slots;
+    juror_pool_singleton _juror_pool;
+    retention_singleton _retention;
+    panel_config_singleton _panel_config;
+    hash_migration_singleton _hash_migration;
+    service_stats_singleton _service_stats;
+
+    std::optional<service_stats> _stats; // The statistics read by the current action (written back once by the destructor).
+
+    // The rows loaded once for an action performed by a participant of a digital handshake.
+    struct participant_context
+    {
+        digital_handshakes_table::const_iterator handshake; // The digital handshake row.
+        bool is_dealer;                                      // True when the user is the dealer, false when the user is the bidder.
+    };
 
     /***** Helpers Methods *****/
 
-    // Helper to get the last value for the primary key of the requests table.
+    // Helper to get the key of the users `byrating` index for a user with the given rating.
+    static uint128_t rating_key(uint64_t rating, eosio::name username) { return (uint128_t(rating) << 64) | username.value; }
+
+    // Helper to get the key of the proposals `byrequest` index for a request and bidder pair.
+    static uint128_t proposal_key(int32_t request_id, eosio::name bidder) { return (uint128_t(uint32_t(request_id)) << 64) | bidder.value; }
+
+    // Helper to get the primary key of the rounds table for a round of a digital handshake negotiation.
+    static uint64_t round_key(int32_t dhs_id, uint32_t round) { return (uint64_t(uint32_t(dhs_id)) << 32) | round; }
+
+    // Helper to append a proposal to the negotiation history of a digital handshake.
+    void store_round(eosio::name payer, int32_t dhs_id, uint32_t round, const eosio::checksum256 &contractual_terms_hash, eosio::asset price, uint32_t deadline);
+
+    // Helper to get the highest primary key stored in the requests table (used only to seed the request counter).
     int32_t get_last_request_id();
 
+    // Helper to allocate the primary key for a new request from the persisted request counter.
+    int32_t next_request_id();
+
+    // Helper to erase up to `budget` rows of a finished digital handshake (rounds and proposals first). Returns true when every row is gone.
+    bool archive_handshake(int32_t dhs_id, uint32_t &budget);
+
+    // Helper to decode a hex SHA256 written by the previous contract version (an invalid string becomes the zero checksum).
+    static eosio::checksum256 decode_hash(const std::string &hash);
+
+    // Helper to rewrite, keeping the RAM payer, the rows of a table from the legacy to the current layout. Every child row stored by `store_children`
+    // (proposals, rounds, pool slots, assignments) and every rewritten row costs a unit of `budget`. Returns true when the table is done.
+    template <eosio::name::raw TableName, typename LegacyRow, typename ChildWriter, typename Converter>
+    bool migrate_rows(hash_migration &migration, uint32_t &budget, ChildWriter store_children, Converter convert);
+
+    // Helpers to store, paid by the contract, the entry of a migrated row in the `index`-th secondary index of a table (the legacy tables had none).
+    void store_secondary(eosio::name table, uint8_t index, uint64_t primary, uint64_t secondary);
+    void store_secondary(eosio::name table, uint8_t index, uint64_t primary, uint128_t secondary);
+
+    // Helper to remove the entry of a row from the `index`-th uint64_t secondary index of a table (an index dropped by the current layout).
+    void remove_secondary(eosio::name table, uint8_t index, uint64_t primary);
+
+    // Helper to check, at the top of every state-changing action, that the hash migration is done (a fresh contract is marked as migrated).
+    void require_migrated(const char *action_name);
+
+    // Helper to check if any table rewritten by the hash migration has rows (used only while no migration progress is stored).
+    bool has_stored_rows();
+
+    // Helper to load the handshake of an action performed by one of its participants, checking its status and the user role.
+    // The dealer and bidder of a handshake are always registered users, so the users table is read only to report a failure.
+    template <uint8_t Status, uint8_t Role>
+    participant_context load_participant(eosio::name user, int32_t dhs_id, const char *action_name);
+
+    // Helper to move a digital handshake row through the transition table (the transition is verified at compile time).
+    template <uint8_t From, uint8_t To>
+    void set_status(digital_handshake &handshake);
+
+    // Helper to move `count` digital handshakes between two status of the statistics (NO_STATUS when created or erased).
+    void count_status(uint8_t from, uint8_t to, uint64_t count = 1);
+
+    // Helper to get the service statistics, read at most once per action (the destructor writes them back).
+    service_stats &get_stats();
+
+    // Helper to record that a juror of a dispute panel has still to vote (increments the juror load).
+    void add_assignment(eosio::name payer, eosio::name juror, int32_t dhs_id);
+
+    // Helper to close the assignment of a juror who has voted (decrements the juror load).
+    void close_assignment(eosio::name juror, int32_t dhs_id);
+
+    // Helper to store the proposal of a bidder for a request. Returns the reason of the failure, or nullptr when the proposal is stored.
+    const char *try_propose(eosio::name bidder, int32_t request_id);
+
+    // Helper to parse the decimal digital handshake identifier of a transfer memo without allocations. Returns false when the memo is not valid.
+    static bool parse_dhs_id(const std::string &memo, int32_t &dhs_id);
+
     // Helper to get current UTC time.
     uint32_t now();
 
     // Helper to get the DHS token balance from 'dhstoken' contract for a 'user'.
     asset get_user_balance(name user);
 
-    // Helper to get the a pseudo-random integer number from 0 to range-1.
-    int random(const int range);
+    // Helper to draw `count` distinct slots of the juror pool from a single entropy read (at most one write, to the seed row).
+    std::vector<uint64_t> draw_jurors(uint64_t count, uint64_t pool_size);
+
+    // Helper to append a juror to the last slot of the juror pool.
+    void add_pool_juror(eosio::name juror);
 
-    // Helper to get a vector of the usernames of each juror registered on the service.
-    vector<eosio::name> get_jurors();
+    // Helper to remove a juror from the juror pool, moving the juror of the last slot into the freed one.
+    void remove_pool_juror(eosio::name juror);
+
+    // Helper to get the juror slot row stored in the given slot of the juror pool.
+    const juror_slot &get_pool_slot(uint64_t slot);
 
     // This is just to help the account lookup from 'dhstoken' smart contract and is not exposed in any manner.
     struct [[eosio::table]] account
@@ -198,13 +548,27 @@ public:
                                                                         _users(receiver, receiver.value),        // Init users table with a global scope.
                                                                         _jurors(receiver, receiver.value),       // Init jurors table with a global scope.
                                                                         _requests(receiver, receiver.value),     // Init requests table with a global scope.
-                                                                        _negotiations(receiver, receiver.value), // Init negotiation table with a global scope.
+                                                                        _proposals(receiver, receiver.value),    // Init proposals table with a global scope.
+                                                                        _rounds(receiver, receiver.value),       // Init negotiation rounds table with a global scope.
                                                                         _handshakes(receiver, receiver.value),   // Init digital handshakes table with a global scope.
                                                                         _disputes(receiver, receiver.value),     // Init disputes table with a global scope.
+                                                                        _assignments(receiver, receiver.value),  // Init juror assignments table with a global scope.
                                                                         _seed(receiver, receiver.value),
-                                                                        dhs_symbol("DHS", 4), // Init DHS token symbol and decimals.
-                                                                        fixed_stake(30.0000, symbol("DHS", 4))
+                                                                        _request_counter(receiver, receiver.value), // Init request counter with a global scope.
+                                                                        _juror_slots(receiver, receiver.value),     // Init juror pool slots table with a global scope.
+                                                                        _juror_pool(receiver, receiver.value),      // Init juror pool size with a global scope.
+                                                                        _retention(receiver, receiver.value),       // Init archive retention with a global scope.
+                                                                        _panel_config(receiver, receiver.value),    // Init juror panel size with a global scope.
+                                                                        _hash_migration(receiver, receiver.value),  // Init hash migration progress with a global scope.
+                                                                        _service_stats(receiver, receiver.value)    // Init service statistics with a global scope.
+    {
+    }
+
+    ~dhsservice()
     {
+        // Write back the statistics once, whatever the number of updates of the action.
+        if (_stats.has_value())
+            _service_stats.set(*_stats, get_self());
     }
 
     /**
@@ -216,7 +580,7 @@ public:
      * @param external_data_hash - the sha256 of the personal data of the user.
      *
      * @pre Invalid role provided,
-     * @pre External data hash must be a valid SHA256 value,
+     * @pre External data hash must be a non-zero SHA256 value,
      * @pre Username already registered as user,
      * @pre Username already registered as juror.
      *
@@ -224,7 +588,72 @@ public:
      */
     [[eosio::action]] void signup(eosio::name username,
                                   uint8_t role,
-                                  std::string external_data_hash);
+                                  eosio::checksum256 external_data_hash);
+
+    /**
+     * Unregister juror action.
+     *
+     * @details Allows `juror` account to leave the service, removing it from the pool of jurors that can be picked for disputes.
+     * @param juror - the juror who wants to leave the service.
+     *
+     * @pre Juror not registered,
+     * @pre Juror designated for a dispute and not voted yet.
+     *
+     * If validation is successful, the juror entry gets erased and the juror of the last pool slot takes over its slot.
+     */
+    [[eosio::action]] void unregjuror(eosio::name juror);
+
+    /**
+     * Seed juror pool action.
+     *
+     * @details Migration that adds the jurors registered before the juror pool existed to the pool, in username order.
+     * @param from - the username where to start (the last username processed by a previous call, or an empty name),
+     * @param max_rows - the maximum number of jurors to visit.
+     *
+     * @pre Only the dhsservice contract account can seed the pool,
+     * @pre Hash migration not done (`migratehash` adds the migrated jurors to the pool).
+     *
+     * Jurors already in the pool are skipped, so the action can be repeated until every juror has been visited.
+     */
+    [[eosio::action]] void seedpool(eosio::name from, uint32_t max_rows);
+
+    /**
+     * Seed request counter action.
+     *
+     * @details One-shot migration that seeds the persisted request counter from the highest identifier stored in the requests table.
+     * Needed only for contracts which have posted requests before the counter existed; `postrequest` seeds it lazily otherwise.
+     *
+     * @pre Only the dhsservice contract account can seed the counter,
+     * @pre Hash migration not done,
+     * @pre Request counter already seeded.
+     *
+     * If validation is successful, the request counter singleton gets created with the last request identifier.
+     */
+    [[eosio::action]] void seedreqid();
+
+    /**
+     * Migrate hashes action.
+     *
+     * @details Migration that rewrites the rows stored with 64 characters hex hashes, storing the hashes as checksum256.
+     * It must run right after deploying the new contract version: every other state-changing action fails until the migration is done
+     * (a contract deployed without rows of the previous version is marked as migrated by its first action).
+     * The migrated jurors are added to the juror pool, so the assignments created for the legacy disputes count in the load of their jurors.
+     * The bidders list of the legacy requests is moved into the proposals table (the proposals rows are paid by the contract).
+     * The legacy negotiation rows are folded into the related digital handshake rows (and erased) while the handshakes are migrated,
+     * their proposals vectors becoming the rows of the rounds table (paid by the contract).
+     * The migrated users, jurors, open requests and handshakes are counted in the service statistics, and the migrated users,
+     * requests and handshakes get their entries in the secondary indexes (paid by the contract). The entries of the dropped
+     * juror indexes of the legacy disputes are removed.
+     * @param max_rows - the maximum number of rows to rewrite or store (every child row of a legacy row counts as a row).
+     *
+     * @pre Only the dhsservice contract account can migrate the hashes,
+     * @pre Max rows must be greater than zero,
+     * @pre Migration already done.
+     *
+     * The rows keep their RAM payer (that gets back the freed RAM). The action can be repeated until every table has been migrated,
+     * a call cut by `max_rows` between the child rows of a legacy row is resumed from the next child.
+     */
+    [[eosio::action]] void migratehash(uint32_t max_rows);
 
     /**
      * Post a new request action.
@@ -240,14 +669,14 @@ public:
      * @pre Price is lower or equal to zero,
      * @pre Price refers not to a DHS token price,
      * @pre Summary must be not empty,
-     * @pre Contractual Terms hash must be a valid SHA256 hash,
+     * @pre Contractual Terms hash must be a non-zero SHA256 hash,
      * @pre Deadline must be greater than now,
      *
      * If validation is successful, a new entry in the requests table for global contract scope gets created.
      */
     [[eosio::action]] void postrequest(eosio::name dealer,
                                        std::string summary,
-                                       std::string contractual_terms_hash,
+                                       eosio::checksum256 contractual_terms_hash,
                                        eosio::asset price,
                                        uint32_t deadline);
 
@@ -264,10 +693,36 @@ public:
      * @pre Bidder is the dealer who has posted the request,
      * @pre Bidder already proposed for the request,
      * 
-     * If validation is successful, the request's entry will be modified, pushing the bidder to the proponent's vector.
+     * If validation is successful, a new entry in the proposals table for the request and bidder gets created.
      */
     [[eosio::action]] void propose(eosio::name bidder, int32_t request_id);
 
+    /**
+     * Batch propose action.
+     *
+     * @details Allows `bidder` user account to propose for many requests in a single action, validating the bidder only once.
+     * @param bidder - the bidder who proposes for the requests,
+     * @param request_ids - the identifiers of the requests (at most 20).
+     *
+     * @pre Bidder not already registered as user,
+     * @pre Request identifiers must be between 1 and 20.
+     *
+     * Every request is validated as in `propose`, but a request which cannot be proposed does not abort the batch: the proposals for
+     * the other requests get created and the failed requests, with their reasons, are reported through an inline `logbatch` action.
+     */
+    [[eosio::action]] void batchpropose(eosio::name bidder, std::vector<int32_t> request_ids);
+
+    /**
+     * Log batch action.
+     *
+     * @details Inline notification which records in the action traces the requests of a batch proposal that have not been proposed.
+     * @param bidder - the bidder of the batch proposal,
+     * @param failures - the failed requests with the reason of the failure.
+     *
+     * @pre Only the dhsservice contract account can log a batch proposal.
+     */
+    [[eosio::action]] void logbatch(eosio::name bidder, std::vector<batch_failure> failures);
+
     /**
      * Select a bidder for the request.
      *
@@ -303,14 +758,14 @@ public:
      * @pre User is not the dealer/bidder of the digital handshake,
      * @pre Someone (dealer/bidder) has already accepted the terms,
      * @pre User is the last user who proposed new terms,
-     * @pre Contractual Terms hash must be a valid SHA256 hash,
+     * @pre Contractual Terms hash must be a non-zero SHA256 hash,
      * @pre Price is lower or equal to zero,
      * @pre Price is not in DHS tokens,
      * @pre Deadline must be greater than now, 
      * 
-     * If validation is successful the entry for the negotiation will be modified pushing the new proposal.
+     * If validation is successful a new entry for the negotiation round will be stored and the handshake will be modified to point at the new proposal.
      */
-    [[eosio::action]] void negotiate(eosio::name user, int32_t dhs_id, std::string contractual_terms_hash, eosio::asset price, uint32_t deadline);
+    [[eosio::action]] void negotiate(eosio::name user, int32_t dhs_id, eosio::checksum256 contractual_terms_hash, eosio::asset price, uint32_t deadline);
 
     /**
      * Accept negotiation contractual terms for a digital handshake.
@@ -327,7 +782,7 @@ public:
      * @pre User is the last user who proposed new terms,
      * @pre User has already accepted the terms,
      * 
-     * If validation is successful, the entry for the negotiation will be modified, setting to true the relative boolean (dealer/bidder). 
+     * If validation is successful, the entry for the handshake will be modified, setting to true the relative boolean (dealer/bidder). 
      * When both dealer and bidder have accepted terms, the handshake status will be set to execution.
      */
     [[eosio::action]] void acceptterms(eosio::name user, int32_t dhs_id);
@@ -336,7 +791,7 @@ public:
      * Listen for lock tokens action.
      *
      * @details Listen on `dhstoken::transfer` action calls where the `to` parameter refers to the `dhsservice` contract. The contract will then atomically resend the tokens on behalf
-     * of the user to the dhsescrow smart contract.
+     * of the user to the dhsescrow smart contract with a single inline transfer (memo "<user>:<handshake identifier>:<dealer|bidder>"), which the dhsescrow contract tracks from its notification.
      * Whenever the `dealer` and `bidder` have both accepted the contractual terms and sent the tokens to the escrow, this action will set the related handshake status to execution.
      * @param from - the dealer/bidder who wants to send tokens for an handshake,
      * @param to - the name of the dhsescrow smart contract,
@@ -345,14 +800,15 @@ public:
      *
      * @pre To is the dhsservice contract name,
      * @pre From is not recorded as user in the platform,
-     * @pre Digital handshake identifier not valid (must be provided in the memo, e.g. "1"),
+     * @pre Memo is not a decimal handshake identifier (e.g. "1"),
+     * @pre Digital handshake identifier not valid,
      * @pre Digital handshake identifier refers to an handshake with a non lock status,
      * @pre From is not the dealer/bidder of the digital handshake,
      * @pre From is dealer and quantity is not equal to fixed stake amount plus handshake price,
      * @pre From is bidder and quantity is not equal to fixed stake amount,
      * @pre From has already sent the tokens for this handshake,
      * 
-     * If validation is successful, it will be recorded on the negotiation table row related to the handshake that the `from` user has locked the tokens and 
+     * If validation is successful, it will be recorded on the handshake row that the `from` user has locked the tokens and 
      * store the locked tokens in the dhsescrow contract table. If both dealer and bidder have locked the tokens, the handshake will pass to LOCK status.
      */
     [[eosio::on_notify("dhstoken::transfer")]] void notifylock(eosio::name from, eosio::name to, eosio::asset quantity, std::string memo);
@@ -395,6 +851,20 @@ public:
      */
     [[eosio::action]] void expired(eosio::name user, int32_t dhs_id);
 
+    /**
+     * Sweep expired handshakes action.
+     *
+     * @details Allows anyone to expire, in a single transaction, the handshakes left in execution status after their deadline.
+     * Handshakes are visited in deadline order and both the dealer and the bidder get back the tokens they have not unlocked yet.
+     * @param max_rows - the maximum number of handshakes to expire (at most 50).
+     *
+     * @pre Max rows must be between 1 and 50.
+     *
+     * For each expired handshake, the dhsescrow contract will send the locked tokens back to the dealer and/or bidder and the handshake will pass to EXPIRED status.
+     * The action stops at the first handshake with a deadline not yet expired or after `max_rows` handshakes.
+     */
+    [[eosio::action]] void sweepexpired(uint32_t max_rows);
+
     /**
      * Accept job action.
      * @details Allows `dealer` to accept the job for a handshake. The service will automatically unlock and execute the payments with DHS tokens to corresponding users. 
@@ -415,7 +885,7 @@ public:
     /**
      * Open dispute action.
      * @details Allows `dealer` to open a dispute after a job notification from the bidder. 
-     * The action involves a pseudo-random choice of three jurors who are designated to vote in favour of the dealer or bidder to declare the winner of the dispute.
+     * The action involves a pseudo-random choice of a panel of jurors (three by default, see `setpanel`) who are designated to vote in favour of the dealer or bidder to declare the winner of the dispute.
      * @param dealer - the dealer who starts the dispute for an handshake,
      * @param dhs_id - the identifier of the digital handshake.
      *
@@ -423,9 +893,10 @@ public:
      * @pre Digital handshake identifier not valid
      * @pre Digital handshake identifier refers to an handshake with a non confirmation status,
      * @pre User is not the dealer of the digital handshake,
+     * @pre Not enough registered jurors for the panel,
      * 
      * If validation is successful it will be recorded on the handshake table row changing the status to dispute. It will be recorded on the disputes table row related to the handshake that 
-     * reports the three selected jurors.
+     * reports the selected jurors, and an assignment for each of them.
     */
     [[eosio::action]] void opendispute(eosio::name dealer, int32_t dhs_id);
 
@@ -440,12 +911,12 @@ public:
      * @pre Digital handshake identifier not valid
      * @pre Digital handshake identifier refers to an handshake with a non dispute status,
      * @pre User is not the dealer/bidder of the digital handshake,
-     * @pre Motivation hash must be a valid SHA256 hash,
+     * @pre Motivation hash must be a non-zero SHA256 hash,
      * 
      * If validation is successful, it will be recorded on the handshake table row the motivation hash for the user. Also, when both dealer
      * and bidder have recorded the motivation, the status of the handshake will change to voting.
     */
-    [[eosio::action]] void motivate(eosio::name user, int32_t dhs_id, std::string motivation_hash);
+    [[eosio::action]] void motivate(eosio::name user, int32_t dhs_id, eosio::checksum256 motivation_hash);
 
     /**
      * Vote action.
@@ -465,4 +936,49 @@ public:
      * expressed a vote, the dhsescrow will redistribute tokens between jurors, dealer, bidder and, it will set the handshake status to resolved.
     */
     [[eosio::action]] void vote(eosio::name juror, int32_t dhs_id, eosio::name preference);
-};
\ No newline at end of file
+
+    /**
+     * Set retention action.
+     *
+     * @details Allows the dhsservice contract account to configure how long finished handshakes are kept before they can be archived.
+     * @param retention - the seconds after the handshake deadline during which the rows are kept.
+     *
+     * @pre Only the dhsservice contract account can set the retention.
+     */
+    [[eosio::action]] void setretention(uint32_t retention);
+
+    /**
+     * Set panel action.
+     *
+     * @details Allows the dhsservice contract account to configure the number of jurors drawn for the next disputes.
+     * @param panel_size - the number of jurors of a dispute panel.
+     *
+     * @pre Only the dhsservice contract account can set the panel size,
+     * @pre Panel size must be odd and at most 15.
+     */
+    [[eosio::action]] void setpanel(uint8_t panel_size);
+
+    /**
+     * Archive action.
+     *
+     * @details Allows anyone to erase, in bounded batches, the rows of the handshakes in ACCEPTED, RESOLVED or EXPIRED status whose
+     * deadline is older than the retention window. The RAM of every erased row goes back to the account that paid for it.
+     * @param max_rows - the maximum number of rows to erase (at most 100).
+     *
+     * @pre Max rows must be between 1 and 100.
+     *
+     * For each handshake, the negotiation rounds and the request proposals are erased first; then a summary is sent to `logarchive`
+     * and the request, dispute and handshake rows are erased. A handshake cut by `max_rows` is completed by the next call.
+     */
+    [[eosio::action]] void archive(uint32_t max_rows);
+
+    /**
+     * Log archive action.
+     *
+     * @details Inline notification which records in the action traces the summary of an archived digital handshake.
+     * @param summary - the summary of the archived digital handshake.
+     *
+     * @pre Only the dhsservice contract account can log an archived handshake.
+     */
+    [[eosio::action]] void logarchive(archived_handshake summary);
+};
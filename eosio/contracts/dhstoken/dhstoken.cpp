@@ -100,6 +100,43 @@ namespace eosio
       add_balance(to, quantity, payer);
    }
 
+   void token::transfermany(const name &from,
+                            const std::vector<std::pair<name, asset>> &transfers,
+                            const string &memo)
+   {
+      require_auth(from);
+      check(transfers.size() > 0, "no transfers");
+      check(memo.size() <= 256, "memo has more than 256 bytes");
+
+      auto sym = transfers[0].second.symbol.code();
+      stats statstable(get_self(), sym.raw());
+      const auto &st = statstable.get(sym.raw());
+
+      require_recipient(from);
+
+      // Validate and credit every recipient, accumulating the amount to debit from the sender.
+      asset total(0, st.supply.symbol);
+
+      for (const auto &[to, quantity] : transfers)
+      {
+         check(from != to, "cannot transfer to self");
+         check(is_account(to), "to account does not exist");
+         check(quantity.is_valid(), "invalid quantity");
+         check(quantity.amount > 0, "must transfer positive quantity");
+         check(quantity.symbol == st.supply.symbol, "symbol precision mismatch");
+
+         require_recipient(to);
+
+         total += quantity;
+
+         auto payer = has_auth(to) ? to : from;
+
+         add_balance(to, quantity, payer);
+      }
+
+      sub_balance(from, total);
+   }
+
    void token::sub_balance(const name &owner, const asset &value)
    {
       accounts from_acnts(get_self(), owner.value);
@@ -4,6 +4,8 @@
 #include <eosio/eosio.hpp>
 
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace eosiosystem
 {
@@ -73,6 +75,22 @@ namespace eosio
                                       const name &to,
                                       const asset &quantity,
                                       const string &memo);
+
+      /**
+          * Allows `from` account to transfer to each account in `transfers` the paired quantity of tokens.
+          * The `from` account is debited once with the total quantity and every recipient is credited in the same action.
+          *
+          * @param from - the account to transfer from,
+          * @param transfers - the list of recipient accounts with the quantity of tokens to be transferred to each of them,
+          * @param memo - the memo string to accompany the transaction.
+          *
+          * @pre The list of transfers must not be empty,
+          * @pre Every recipient must be an existing account different from `from`,
+          * @pre Every quantity must be positive and share the same token symbol.
+          */
+      [[eosio::action]] void transfermany(const name &from,
+                                          const std::vector<std::pair<name, asset>> &transfers,
+                                          const string &memo);
       /**
           * Allows `ram_payer` to create an account `owner` with zero balance for
           * token `symbol` at the expense of `ram_payer`.
@@ -116,6 +134,7 @@ namespace eosio
       using issue_action = eosio::action_wrapper<"issue"_n, &token::issue>;
       using retire_action = eosio::action_wrapper<"retire"_n, &token::retire>;
       using transfer_action = eosio::action_wrapper<"transfer"_n, &token::transfer>;
+      using transfermany_action = eosio::action_wrapper<"transfermany"_n, &token::transfermany>;
       using open_action = eosio::action_wrapper<"open"_n, &token::open>;
       using close_action = eosio::action_wrapper<"close"_n, &token::close>;
 
@@ -0,0 +1,188 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "dhs_chain.hpp"
+
+namespace
+{
+    // Every iteration consumes a handshake prepared before the timed loop, so the iterations are fixed instead of being
+    // estimated by the library (the tables keep a size close to the benchmark argument).
+    constexpr int64_t iterations = 256;
+
+    // Run each action with 10 to 10000 rows already stored in the tables it reads, fitting the complexity over the sizes.
+    void table_sizes(benchmark::internal::Benchmark *bench)
+    {
+        bench->RangeMultiplier(10)->Range(10, 10000)->Iterations(iterations)->Unit(benchmark::kMicrosecond)->Complexity();
+    }
+
+    // Prepare `count` handshakes at the given stage.
+    std::vector<dhs_chain::handshake> prepare(dhs_chain &chain, dhs_chain::stage target, int64_t count)
+    {
+        std::vector<dhs_chain::handshake> handshakes;
+        handshakes.reserve(count);
+
+        for (int64_t i = 0; i < count; i++)
+            handshakes.push_back(chain.advance(target));
+
+        return handshakes;
+    }
+
+    // Run a benchmark, reporting a contract check failure (e.g. a broken setup) as a benchmark error.
+    template <typename Body>
+    void guarded(benchmark::State &state, Body &&body)
+    {
+        try
+        {
+            body();
+            state.SetComplexityN(state.range(0));
+        }
+        catch (const eosio::check_failure &failure)
+        {
+            state.SkipWithError(failure.what());
+        }
+    }
+
+    void BM_postrequest(benchmark::State &state)
+    {
+        guarded(state, [&] {
+            dhs_chain chain;
+            eosio::name dealer = chain.add_user();
+
+            for (int64_t i = 0; i < state.range(0); i++)
+                chain.post_request(dealer);
+
+            for (auto _ : state)
+                chain.post_request(dealer);
+        });
+    }
+
+    void BM_propose(benchmark::State &state)
+    {
+        guarded(state, [&] {
+            dhs_chain chain;
+            prepare(chain, dhs_chain::PROPOSED, state.range(0));
+
+            eosio::name dealer = chain.add_user();
+            eosio::name bidder = chain.add_user();
+            std::vector<int32_t> requests;
+
+            for (int64_t i = 0; i < iterations; i++)
+                requests.push_back(chain.post_request(dealer));
+
+            size_t next = 0;
+
+            for (auto _ : state)
+                chain.propose(bidder, requests[next++]);
+        });
+    }
+
+    void BM_negotiate(benchmark::State &state)
+    {
+        guarded(state, [&] {
+            dhs_chain chain;
+            prepare(chain, dhs_chain::NEGOTIATION, state.range(0));
+
+            auto subjects = prepare(chain, dhs_chain::NEGOTIATION, iterations);
+            size_t next = 0;
+
+            // The request terms are the first round, so the bidder proposes the second one.
+            for (auto _ : state)
+            {
+                const auto &dhs = subjects[next++];
+
+                chain.push_service({dhs.bidder}, [&](auto &c) {
+                    c.negotiate(dhs.bidder, dhs.id, dhs_chain::hash(dhs.id), dhs_chain::price(), chain.deadline());
+                });
+            }
+        });
+    }
+
+    void BM_opendispute(benchmark::State &state)
+    {
+        guarded(state, [&] {
+            dhs_chain chain;
+
+            for (int64_t i = 0; i < state.range(0); i++)
+                chain.add_juror();
+
+            prepare(chain, dhs_chain::DISPUTE, state.range(0));
+
+            auto subjects = prepare(chain, dhs_chain::CONFIRMATION, iterations);
+            size_t next = 0;
+
+            for (auto _ : state)
+                chain.open_dispute(subjects[next++]);
+        });
+    }
+
+    void BM_vote(benchmark::State &state)
+    {
+        guarded(state, [&] {
+            dhs_chain chain;
+
+            // A pool as large as the default panel, so every juror is drawn for every dispute.
+            std::vector<eosio::name> jurors;
+
+            for (int i = 0; i < 3; i++)
+                jurors.push_back(chain.add_juror());
+
+            prepare(chain, dhs_chain::VOTING, state.range(0));
+
+            auto subjects = prepare(chain, dhs_chain::VOTING, iterations);
+
+            for (const auto &dhs : subjects)
+            {
+                chain.vote(jurors[0], dhs, dhs.dealer);
+                chain.vote(jurors[1], dhs, dhs.bidder);
+            }
+
+            size_t next = 0;
+
+            // The last vote of the panel, which also settles the dispute.
+            for (auto _ : state)
+            {
+                const auto &dhs = subjects[next++];
+                chain.vote(jurors[2], dhs, dhs.dealer);
+            }
+        });
+    }
+
+    void BM_resolved(benchmark::State &state)
+    {
+        guarded(state, [&] {
+            dhs_chain chain;
+
+            // The escrow does not read the dhsservice tables, so its ledger is filled directly.
+            std::vector<dhs_chain::handshake> locks;
+
+            for (int64_t i = 0; i < state.range(0) + iterations; i++)
+            {
+                locks.push_back({int32_t(i + 1), dhs_chain::account("user", 2 * i), dhs_chain::account("user", 2 * i + 1)});
+                chain.escrow_lock(locks.back());
+            }
+
+            std::vector<eosio::name> jurors{dhs_chain::account("juror", 0), dhs_chain::account("juror", 1), dhs_chain::account("juror", 2)};
+            size_t next = state.range(0);
+
+            for (auto _ : state)
+            {
+                const auto &dhs = locks[next++];
+
+                chain.push<dhsescrow>(dhs_chain::escrow_account, dhs_chain::escrow_account, {dhs_chain::service_account}, [&](auto &c) {
+                    c.resolved(dhs_chain::service_account, dhs.id, dhs_chain::price(), jurors, uint8_t(dhs.id % 2));
+                });
+            }
+        });
+    }
+
+} // namespace
+
+BENCHMARK(BM_postrequest)->Apply(table_sizes);
+BENCHMARK(BM_propose)->Apply(table_sizes);
+BENCHMARK(BM_negotiate)->Apply(table_sizes);
+BENCHMARK(BM_opendispute)->Apply(table_sizes);
+BENCHMARK(BM_vote)->Apply(table_sizes);
+BENCHMARK(BM_resolved)->Apply(table_sizes);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,199 @@
+#include "dhs_chain.hpp"
+
+#include <string>
+
+namespace
+{
+    constexpr int64_t token_supply = 1000000000 * dhs::token_unit; // The DHS tokens issued when the chain is created.
+    constexpr int64_t user_funds = 1000 * dhs::token_unit;         // The DHS tokens sent to every new user.
+    constexpr uint32_t deadline_delay = 30 * 24 * 3600;            // The delivery deadline of the requests, in seconds from now.
+
+    // Roles accepted by `dhsservice::signup`.
+    constexpr uint8_t user_role = 0;
+    constexpr uint8_t juror_role = 1;
+} // namespace
+
+dhs_chain::dhs_chain()
+{
+    eosio::host::reset();
+
+    push<eosio::token>(token_account, token_account, {token_account}, [](auto &c) {
+        c.create(token_account, dhs::make_asset(token_supply));
+    });
+    push<eosio::token>(token_account, token_account, {token_account}, [](auto &c) {
+        c.issue(token_account, dhs::make_asset(token_supply), "Native chain supply");
+    });
+}
+
+eosio::name dhs_chain::account(const char *prefix, uint64_t index)
+{
+    // Base 31 suffix with the characters allowed in account names (a fixed length keeps the names distinct).
+    static constexpr char digits[] = "12345abcdefghijklmnopqrstuvwxyz";
+
+    std::string value(prefix);
+
+    for (int i = 0; i < 5; i++)
+    {
+        value += digits[index % 31];
+        index /= 31;
+    }
+
+    return eosio::name(std::string_view(value));
+}
+
+eosio::checksum256 dhs_chain::hash(uint64_t value)
+{
+    return eosio::sha256(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+eosio::asset dhs_chain::price()
+{
+    return dhs::make_asset(10 * dhs::token_unit);
+}
+
+uint32_t dhs_chain::deadline() const
+{
+    return eosio::current_time_point().sec_since_epoch() + deadline_delay;
+}
+
+eosio::name dhs_chain::add_user()
+{
+    eosio::name user = account("user", _users++);
+
+    push_service({user}, [&](auto &c) {
+        c.signup(user, user_role, hash(user.value));
+    });
+    push<eosio::token>(token_account, token_account, {token_account}, [&](auto &c) {
+        c.transfer(token_account, user, dhs::make_asset(user_funds), "Native chain funds");
+    });
+
+    return user;
+}
+
+eosio::name dhs_chain::add_juror()
+{
+    eosio::name juror = account("juror", _jurors++);
+
+    push_service({juror}, [&](auto &c) {
+        c.signup(juror, juror_role, hash(juror.value));
+    });
+
+    return juror;
+}
+
+dhs_chain::handshake dhs_chain::advance(stage target)
+{
+    handshake dhs{0, add_user(), add_user()};
+
+    dhs.id = post_request(dhs.dealer);
+    propose(dhs.bidder, dhs.id);
+
+    if (target >= NEGOTIATION)
+        select_bidder(dhs);
+
+    if (target >= EXECUTION)
+    {
+        accept_terms(dhs);
+        lock(dhs);
+    }
+
+    if (target >= CONFIRMATION)
+        end_job(dhs);
+
+    if (target >= DISPUTE)
+        open_dispute(dhs);
+
+    if (target >= VOTING)
+        motivate(dhs);
+
+    return dhs;
+}
+
+int32_t dhs_chain::post_request(eosio::name dealer)
+{
+    push_service({dealer}, [&](auto &c) {
+        c.postrequest(dealer, "Native chain request", hash(_last_request_id + 1), price(), deadline());
+    });
+
+    return ++_last_request_id;
+}
+
+void dhs_chain::propose(eosio::name bidder, int32_t request_id)
+{
+    push_service({bidder}, [&](auto &c) {
+        c.propose(bidder, request_id);
+    });
+}
+
+void dhs_chain::select_bidder(const handshake &dhs)
+{
+    push_service({dhs.dealer}, [&](auto &c) {
+        c.selectbidder(dhs.dealer, dhs.bidder, dhs.id);
+    });
+}
+
+void dhs_chain::accept_terms(const handshake &dhs)
+{
+    // The request terms are the first round, so the bidder accepts first.
+    push_service({dhs.bidder}, [&](auto &c) {
+        c.acceptterms(dhs.bidder, dhs.id);
+    });
+    push_service({dhs.dealer}, [&](auto &c) {
+        c.acceptterms(dhs.dealer, dhs.id);
+    });
+}
+
+void dhs_chain::lock(const handshake &dhs)
+{
+    // Notifications of the transfers from the users to dhsservice, which forwards the tokens to the escrow.
+    push<dhsservice>(service_account, token_account, {dhs.dealer}, [&](auto &c) {
+        c.notifylock(dhs.dealer, service_account, dhs::make_asset(price().amount + dhs::stake_amount), std::to_string(dhs.id));
+    });
+    push<dhsservice>(service_account, token_account, {dhs.bidder}, [&](auto &c) {
+        c.notifylock(dhs.bidder, service_account, dhs::make_asset(dhs::stake_amount), std::to_string(dhs.id));
+    });
+
+    escrow_lock(dhs);
+}
+
+void dhs_chain::escrow_lock(const handshake &dhs)
+{
+    // Notifications of the transfers forwarded by dhsservice (the inline actions sent by `dhsservice::notifylock`).
+    push<dhsescrow>(escrow_account, token_account, {service_account}, [&](auto &c) {
+        c.notifylock(service_account, escrow_account, dhs::make_asset(price().amount + dhs::stake_amount), dhs.dealer.to_string() + ":" + std::to_string(dhs.id) + ":dealer");
+    });
+    push<dhsescrow>(escrow_account, token_account, {service_account}, [&](auto &c) {
+        c.notifylock(service_account, escrow_account, dhs::make_asset(dhs::stake_amount), dhs.bidder.to_string() + ":" + std::to_string(dhs.id) + ":bidder");
+    });
+}
+
+void dhs_chain::end_job(const handshake &dhs)
+{
+    push_service({dhs.bidder}, [&](auto &c) {
+        c.endjob(dhs.bidder, dhs.id);
+    });
+}
+
+void dhs_chain::open_dispute(const handshake &dhs)
+{
+    push_service({dhs.dealer}, [&](auto &c) {
+        c.opendispute(dhs.dealer, dhs.id);
+    });
+}
+
+void dhs_chain::motivate(const handshake &dhs)
+{
+    push_service({dhs.dealer}, [&](auto &c) {
+        c.motivate(dhs.dealer, dhs.id, hash(dhs.dealer.value));
+    });
+    push_service({dhs.bidder}, [&](auto &c) {
+        c.motivate(dhs.bidder, dhs.id, hash(dhs.bidder.value));
+    });
+}
+
+void dhs_chain::vote(eosio::name juror, const handshake &dhs, eosio::name preference)
+{
+    push_service({juror}, [&](auto &c) {
+        c.vote(juror, dhs.id, preference);
+    });
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <eosio/host.hpp>
+
+#include "dhsservice/dhsservice.hpp"
+#include "dhsescrow/dhsescrow.hpp"
+
+/**
+* Native chain of the Digital Handshake contracts
+*
+* @details Drives the dhstoken, dhsservice and dhsescrow contracts on the host stand-in, one contract instance per action
+* as on chain. Inline actions are only recorded by the host, so the helpers replay the effects the benchmarks depend on
+* (e.g. the escrow notification of a lock) as separate actions.
+* @{
+*/
+class dhs_chain
+{
+public:
+    static constexpr eosio::name token_account = "dhstoken"_n;
+    static constexpr eosio::name service_account = "dhsservice"_n;
+    static constexpr eosio::name escrow_account = "dhsescrow"_n;
+
+    // List of values for the stages a handshake can be brought to by `advance`.
+    enum stage : uint8_t
+    {
+        PROPOSED,     // Request posted and proposed by the bidder.
+        NEGOTIATION,  // Bidder selected, terms not accepted yet.
+        EXECUTION,    // Terms accepted and tokens locked by both users.
+        CONFIRMATION, // Job ended by the bidder.
+        DISPUTE,      // Dispute opened by the dealer.
+        VOTING        // Dispute motivated by both users.
+    };
+
+    // The participants of a handshake prepared by `advance`.
+    struct handshake
+    {
+        int32_t id;         // The request (and digital handshake) identifier.
+        eosio::name dealer; // The dealer username.
+        eosio::name bidder; // The bidder username.
+    };
+
+    // Reset the host state and create the DHS token.
+    dhs_chain();
+
+    // Build the n-th account name with the given prefix (e.g. "user" or "juror").
+    static eosio::name account(const char *prefix, uint64_t index);
+
+    // Build a non-zero hash from a number.
+    static eosio::checksum256 hash(uint64_t value);
+
+    // The price of the posted requests and a deadline in the future.
+    static eosio::asset price();
+    uint32_t deadline() const;
+
+    // Register a new funded user / a new juror, returning its username.
+    eosio::name add_user();
+    eosio::name add_juror();
+
+    // Post a request for a new dealer and bring it, with a new bidder, to the given stage.
+    handshake advance(stage target);
+
+    // Single step helpers.
+    int32_t post_request(eosio::name dealer);
+    void propose(eosio::name bidder, int32_t request_id);
+    void select_bidder(const handshake &dhs);
+    void accept_terms(const handshake &dhs);
+    void lock(const handshake &dhs);
+    void escrow_lock(const handshake &dhs);
+    void end_job(const handshake &dhs);
+    void open_dispute(const handshake &dhs);
+    void motivate(const handshake &dhs);
+    void vote(eosio::name juror, const handshake &dhs, eosio::name preference);
+
+    // Run an action of a contract: a fresh instance is built for it and destroyed (writing back its caches) once it returns.
+    template <typename Contract, typename Action>
+    void push(eosio::name receiver, eosio::name code, std::initializer_list<eosio::name> signers, Action &&act)
+    {
+        eosio::host::begin_action(receiver, signers);
+
+        Contract contract(receiver, code, eosio::datastream<const char *>(nullptr, 0));
+        act(contract);
+    }
+
+    template <typename Action>
+    void push_service(std::initializer_list<eosio::name> signers, Action &&act)
+    {
+        push<dhsservice>(service_account, service_account, signers, std::forward<Action>(act));
+    }
+
+private:
+    uint64_t _users = 0;          // The number of registered users.
+    uint64_t _jurors = 0;         // The number of registered jurors.
+    int32_t _last_request_id = 0; // The identifier of the last posted request.
+};
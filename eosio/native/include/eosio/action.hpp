@@ -0,0 +1,100 @@
+#pragma once
+
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "check.hpp"
+#include "host.hpp"
+#include "name.hpp"
+
+namespace eosio
+{
+
+    struct permission_level
+    {
+        permission_level(name a, name p) : actor(a), permission(p) {}
+        permission_level() {}
+
+        name actor;
+        name permission;
+    };
+
+    inline bool has_auth(name n) { return host::state().auths.count(n.value) > 0; }
+
+    inline void require_auth(name n) { check(has_auth(n), "missing authority of " + n.to_string()); }
+
+    inline void require_auth(const permission_level &level) { require_auth(level.actor); }
+
+    inline void require_recipient(name notify_account) { host::state().recipients.push_back(notify_account); }
+
+    template <typename... Accounts>
+    void require_recipient(name notify_account, Accounts... remaining_accounts)
+    {
+        require_recipient(notify_account);
+        require_recipient(remaining_accounts...);
+    }
+
+    // Inline actions are queued on the host state instead of being dispatched.
+    struct action
+    {
+        eosio::name account;
+        eosio::name name;
+        std::vector<permission_level> authorization;
+        std::any data;
+
+        action() = default;
+
+        template <typename T>
+        action(const permission_level &auth, eosio::name a, eosio::name n, T &&value)
+            : account(a), name(n), authorization{auth}, data(std::forward<T>(value))
+        {
+        }
+
+        template <typename T>
+        action(std::vector<permission_level> auths, eosio::name a, eosio::name n, T &&value)
+            : account(a), name(n), authorization(std::move(auths)), data(std::forward<T>(value))
+        {
+        }
+
+        void send() const
+        {
+            std::vector<eosio::name> authorizers;
+            for (const auto &level : authorization)
+                authorizers.push_back(level.actor);
+            host::state().inline_actions.push_back({account, name, std::move(authorizers), data});
+        }
+    };
+
+    template <name::raw Name, auto Action>
+    struct action_wrapper
+    {
+        template <typename Code>
+        constexpr action_wrapper(Code &&code, std::vector<permission_level> &&perms)
+            : code_name(std::forward<Code>(code)), permissions(std::move(perms))
+        {
+        }
+
+        template <typename Code>
+        constexpr action_wrapper(Code &&code, const permission_level &perm)
+            : code_name(std::forward<Code>(code)), permissions({1, perm})
+        {
+        }
+
+        template <typename... Args>
+        action to_action(Args &&...args) const
+        {
+            return action(permissions, code_name, name(Name), std::make_tuple(std::forward<Args>(args)...));
+        }
+
+        template <typename... Args>
+        void send(Args &&...args) const
+        {
+            to_action(std::forward<Args>(args)...).send();
+        }
+
+        name code_name;
+        std::vector<permission_level> permissions;
+    };
+
+} // namespace eosio
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "check.hpp"
+#include "symbol.hpp"
+
+namespace eosio
+{
+
+    struct asset
+    {
+        static constexpr int64_t max_amount = (1LL << 62) - 1;
+
+        int64_t amount = 0;
+        eosio::symbol symbol;
+
+        constexpr asset() {}
+        constexpr asset(int64_t a, eosio::symbol s) : amount(a), symbol{s}
+        {
+            check(is_amount_within_range(), "magnitude of asset amount must be less than 2^62");
+            check(symbol.is_valid(), "invalid symbol name");
+        }
+
+        constexpr bool is_amount_within_range() const { return -max_amount <= amount && amount <= max_amount; }
+        constexpr bool is_valid() const { return is_amount_within_range() && symbol.is_valid(); }
+
+        asset operator-() const { return asset(-amount, symbol); }
+
+        asset &operator-=(const asset &a)
+        {
+            check(a.symbol == symbol, "attempt to subtract asset with different symbol");
+            amount -= a.amount;
+            check(-max_amount <= amount, "subtraction underflow");
+            check(amount <= max_amount, "subtraction overflow");
+            return *this;
+        }
+
+        asset &operator+=(const asset &a)
+        {
+            check(a.symbol == symbol, "attempt to add asset with different symbol");
+            amount += a.amount;
+            check(-max_amount <= amount, "addition underflow");
+            check(amount <= max_amount, "addition overflow");
+            return *this;
+        }
+
+        asset &operator*=(int64_t a)
+        {
+            __int128 tmp = (__int128)amount * (__int128)a;
+            check(tmp <= max_amount, "multiplication overflow");
+            check(tmp >= -max_amount, "multiplication underflow");
+            amount = (int64_t)tmp;
+            return *this;
+        }
+
+        asset &operator/=(int64_t a)
+        {
+            check(a != 0, "divide by zero");
+            check(!(amount == std::numeric_limits<int64_t>::min() && a == -1), "signed division overflow");
+            amount /= a;
+            return *this;
+        }
+
+        friend asset operator+(const asset &a, const asset &b)
+        {
+            asset r = a;
+            r += b;
+            return r;
+        }
+        friend asset operator-(const asset &a, const asset &b)
+        {
+            asset r = a;
+            r -= b;
+            return r;
+        }
+        friend asset operator*(const asset &a, int64_t b)
+        {
+            asset r = a;
+            r *= b;
+            return r;
+        }
+        friend asset operator*(int64_t b, const asset &a) { return a * b; }
+        friend asset operator/(const asset &a, int64_t b)
+        {
+            asset r = a;
+            r /= b;
+            return r;
+        }
+        friend int64_t operator/(const asset &a, const asset &b)
+        {
+            check(b.amount != 0, "divide by zero");
+            check(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+            return a.amount / b.amount;
+        }
+
+        friend bool operator==(const asset &a, const asset &b)
+        {
+            check(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+            return a.amount == b.amount;
+        }
+        friend bool operator!=(const asset &a, const asset &b) { return !(a == b); }
+        friend bool operator<(const asset &a, const asset &b)
+        {
+            check(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+            return a.amount < b.amount;
+        }
+        friend bool operator<=(const asset &a, const asset &b) { return !(b < a); }
+        friend bool operator>(const asset &a, const asset &b) { return b < a; }
+        friend bool operator>=(const asset &a, const asset &b) { return !(a < b); }
+    };
+
+} // namespace eosio
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+namespace eosio
+{
+
+    // Raised by `check` in place of the wasm `eosio_assert` abort; the host harness catches it per action.
+    struct check_failure : std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+
+    constexpr void check(bool pred, const char *msg)
+    {
+        if (!pred)
+            throw check_failure(msg);
+    }
+
+    inline void check(bool pred, const std::string &msg)
+    {
+        if (!pred)
+            throw check_failure(msg);
+    }
+
+} // namespace eosio
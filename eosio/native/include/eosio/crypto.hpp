@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+#include "fixed_bytes.hpp"
+
+namespace eosio
+{
+
+    // SHA-256 over `length` bytes of `data` (plain software implementation, see host.cpp).
+    checksum256 sha256(const char *data, uint32_t length);
+
+} // namespace eosio
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace eosio
+{
+
+    // Only the action payload view handed to `contract`'s constructor is needed on the host.
+    template <typename T>
+    class datastream
+    {
+    public:
+        datastream(T start, size_t s) : _start(start), _pos(start), _end(start + s) {}
+
+        size_t remaining() const { return _end - _pos; }
+
+    private:
+        T _start;
+        T _pos;
+        T _end;
+    };
+
+    // Rows are never serialized on the host (see the raw intrinsics in multi_index.hpp).
+    template <typename T>
+    std::vector<char> pack(const T &)
+    {
+        return {};
+    }
+
+} // namespace eosio
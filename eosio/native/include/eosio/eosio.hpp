@@ -0,0 +1,14 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "action.hpp"
+#include "check.hpp"
+#include "contract.hpp"
+#include "datastream.hpp"
+#include "multi_index.hpp"
+#include "name.hpp"
+#include "print.hpp"
+#include "system.hpp"
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace eosio
+{
+
+    // Host stand-in for the CDT `fixed_bytes<Size>`; only the byte-array view used by the contracts is provided.
+    template <size_t Size>
+    class fixed_bytes
+    {
+    public:
+        constexpr fixed_bytes() : _bytes{} {}
+        constexpr fixed_bytes(const std::array<uint8_t, Size> &arr) : _bytes(arr) {}
+
+        std::array<uint8_t, Size> extract_as_byte_array() const { return _bytes; }
+        const uint8_t *data() const { return _bytes.data(); }
+        uint8_t *data() { return _bytes.data(); }
+        static constexpr size_t size() { return Size; }
+
+        friend bool operator==(const fixed_bytes &a, const fixed_bytes &b) { return a._bytes == b._bytes; }
+        friend bool operator!=(const fixed_bytes &a, const fixed_bytes &b) { return a._bytes != b._bytes; }
+        friend bool operator<(const fixed_bytes &a, const fixed_bytes &b) { return a._bytes < b._bytes; }
+
+    private:
+        std::array<uint8_t, Size> _bytes;
+    };
+
+    using checksum160 = fixed_bytes<20>;
+    using checksum256 = fixed_bytes<32>;
+    using checksum512 = fixed_bytes<64>;
+
+} // namespace eosio
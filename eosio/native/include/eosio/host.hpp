@@ -0,0 +1,78 @@
+#pragma once
+
+#include <any>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <tuple>
+#include <typeindex>
+#include <vector>
+
+#include "name.hpp"
+
+namespace eosio
+{
+
+    struct permission_level;
+
+    /**
+     * Host-side chain state used by the native build.
+     *
+     * @details Replaces the intrinsics the contracts rely on (authorization, clock, TaPoS, inline actions and
+     * notifications, table storage) with plain process state so the contract sources can be compiled and
+     * exercised without nodeos. Nothing here exists in the CDT; contracts must not include this header directly.
+     */
+    namespace host
+    {
+        // An inline action queued by `action::send()`. Inline actions are recorded, not executed.
+        struct inline_action
+        {
+            name account;
+            name action_name;
+            std::vector<name> authorizers;
+            std::any data;
+        };
+
+        // A table stored by a contract, for one C++ row type.
+        struct table_slot
+        {
+            std::shared_ptr<void> storage;
+            size_t row_size = 0;                                                // Size of a row when rows are trivially copyable (0 otherwise).
+            std::function<void(const std::function<void(const void *)> &)> rows; // Visits the bytes of every row.
+        };
+
+        struct chain_state
+        {
+            name receiver;                             // The contract currently executing (what `get_self()` returns).
+            std::set<uint64_t> auths;                  // Accounts that signed the current action.
+            std::set<uint64_t> missing_accounts;       // Accounts `is_account` reports as non-existent.
+            uint64_t now_us = 1600000000ull * 1000000; // Head block time, in microseconds since epoch.
+            uint32_t tapos_prefix = 0;                 // Reference block prefix of the current transaction.
+            std::vector<char> transaction;             // Packed bytes of the current transaction.
+            std::vector<inline_action> inline_actions; // Inline actions sent by the current action.
+            std::vector<name> recipients;              // Accounts notified by the current action.
+            std::map<std::tuple<uint64_t, uint64_t, uint64_t>, std::map<std::type_index, table_slot>> tables; // By (code, scope, table name).
+        };
+
+        chain_state &state();
+
+        // Drop every table, queued action and authorization (fresh chain).
+        void reset();
+
+        // Begin a new action: sets the executing contract and its signers, and clears queued actions and recipients.
+        void begin_action(name receiver, std::initializer_list<name> signers = {});
+
+        inline name current_receiver() { return state().receiver; }
+
+        // Look up the slots of a table, one per row type it has been opened with.
+        inline std::map<std::type_index, table_slot> &table_slots(uint64_t code, uint64_t scope, uint64_t table)
+        {
+            return state().tables[{code, scope, table}];
+        }
+
+    } // namespace host
+
+} // namespace eosio
@@ -0,0 +1,510 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <tuple>
+#include <type_traits>
+#include <typeindex>
+#include <utility>
+
+#include "check.hpp"
+#include "types.h"
+#include "host.hpp"
+#include "name.hpp"
+
+namespace eosio
+{
+
+    constexpr static inline name same_payer{};
+
+    // Raw database intrinsics: the host tables hold typed rows, so byte-level access (used only by migrations) is not available.
+    namespace internal_use_do_not_use
+    {
+        inline int32_t db_find_i64(uint64_t, uint64_t, uint64_t, uint64_t) { return -1; }
+        inline int32_t db_lowerbound_i64(uint64_t, uint64_t, uint64_t, uint64_t) { return -1; }
+        inline void db_update_i64(int32_t, uint64_t, const void *, uint32_t)
+        {
+            check(false, "db_update_i64: raw table access is not available on the host");
+        }
+        inline int32_t db_idx64_store(uint64_t, uint64_t, uint64_t, uint64_t, const uint64_t *)
+        {
+            check(false, "db_idx64_store: raw table access is not available on the host");
+            return -1;
+        }
+        inline int32_t db_idx64_find_primary(uint64_t, uint64_t, uint64_t, uint64_t *, uint64_t) { return -1; }
+        inline void db_idx64_remove(int32_t)
+        {
+            check(false, "db_idx64_remove: raw table access is not available on the host");
+        }
+        inline int32_t db_idx128_store(uint64_t, uint64_t, uint64_t, uint64_t, const unsigned __int128 *)
+        {
+            check(false, "db_idx128_store: raw table access is not available on the host");
+            return -1;
+        }
+    } // namespace internal_use_do_not_use
+
+    template <name::raw IndexName, typename Extractor>
+    struct indexed_by
+    {
+        static constexpr name index_name = name(IndexName);
+        typedef Extractor secondary_extractor_type;
+    };
+
+    template <class Class, typename Type, Type (Class::*PtrToMemberFunction)() const>
+    struct const_mem_fun
+    {
+        typedef typename std::remove_cv_t<std::remove_reference_t<Type>> result_type;
+
+        result_type operator()(const Class &x) const { return (x.*PtrToMemberFunction)(); }
+    };
+
+    /**
+     * In-memory stand-in for `eosio::multi_index`.
+     *
+     * @details Rows live in an ordered map keyed by primary key, each secondary index in an ordered set of
+     * (secondary key, primary key) pairs, so every lookup keeps the O(log n) shape it has on chain. Tables are
+     * shared through the host registry by (code, scope, table name), exactly like chain state, and are dropped
+     * by `eosio::host::reset()`.
+     */
+    template <name::raw TableName, typename T, typename... Indices>
+    class multi_index
+    {
+    private:
+        template <typename Index>
+        using secondary_set = std::set<std::pair<typename Index::secondary_extractor_type::result_type, uint64_t>>;
+
+        struct row
+        {
+            T value;
+            name payer;
+        };
+
+        struct storage
+        {
+            std::map<uint64_t, row> rows;
+            std::tuple<secondary_set<Indices>...> secondaries;
+        };
+
+        template <size_t I>
+        using index_at = std::tuple_element_t<I, std::tuple<Indices...>>;
+
+        template <name::raw IndexName, size_t I = 0>
+        static constexpr size_t index_position()
+        {
+            static_assert(I < sizeof...(Indices), "name not found in indices");
+            if constexpr (index_at<I>::index_name == name(IndexName))
+                return I;
+            else
+                return index_position<IndexName, I + 1>();
+        }
+
+        name _code;
+        uint64_t _scope;
+        std::shared_ptr<storage> _storage;
+
+        template <size_t... Is>
+        static void insert_secondaries(storage &table, const T &obj, std::index_sequence<Is...>)
+        {
+            (std::get<Is>(table.secondaries).emplace(typename index_at<Is>::secondary_extractor_type()(obj), obj.primary_key()), ...);
+        }
+
+        template <size_t... Is>
+        void erase_secondaries(const T &obj, std::index_sequence<Is...>)
+        {
+            (std::get<Is>(_storage->secondaries).erase({typename index_at<Is>::secondary_extractor_type()(obj), obj.primary_key()}), ...);
+        }
+
+        using sequence = std::index_sequence_for<Indices...>;
+
+        // A contract shares its own tables through the host registry. The table of another contract is read through the row
+        // struct of the reader: the rows stored with a struct of the same layout (e.g. the dhstoken `accounts` rows read by
+        // dhsservice) are copied into a private snapshot, which is enough since a contract cannot write the tables of others.
+        static std::shared_ptr<storage> open_storage(name code, uint64_t scope)
+        {
+            auto &slots = host::table_slots(code.value, scope, static_cast<uint64_t>(TableName));
+            auto existing = slots.find(std::type_index(typeid(storage)));
+
+            if (existing != slots.end())
+                return std::static_pointer_cast<storage>(existing->second.storage);
+
+            auto table = std::make_shared<storage>();
+
+            if (code == host::current_receiver())
+            {
+                host::table_slot slot;
+                slot.storage = table;
+                slot.row_size = std::is_trivially_copyable_v<T> ? sizeof(T) : 0;
+                slot.rows = [rows = &table->rows](const std::function<void(const void *)> &visit) {
+                    for (const auto &entry : *rows)
+                        visit(&entry.second.value);
+                };
+
+                slots.emplace(std::type_index(typeid(storage)), std::move(slot));
+                return table;
+            }
+
+            if constexpr (std::is_trivially_copyable_v<T>)
+            {
+                for (const auto &entry : slots)
+                {
+                    if (entry.second.row_size != sizeof(T))
+                        continue;
+
+                    entry.second.rows([&](const void *bytes) {
+                        T obj{};
+                        std::memcpy(&obj, bytes, sizeof(T));
+
+                        auto inserted = table->rows.emplace(obj.primary_key(), row{obj, name()});
+                        insert_secondaries(*table, inserted.first->second.value, sequence{});
+                    });
+                    break;
+                }
+            }
+
+            return table;
+        }
+
+    public:
+        class const_iterator
+        {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = const T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T *;
+            using reference = const T &;
+
+            const_iterator() = default;
+
+            const T &operator*() const { return _itr->second.value; }
+            const T *operator->() const { return &_itr->second.value; }
+
+            const_iterator &operator++()
+            {
+                ++_itr;
+                return *this;
+            }
+            const_iterator operator++(int)
+            {
+                auto tmp = *this;
+                ++_itr;
+                return tmp;
+            }
+            const_iterator &operator--()
+            {
+                check(_itr != _rows->begin(), "cannot decrement iterator at beginning of table");
+                --_itr;
+                return *this;
+            }
+            const_iterator operator--(int)
+            {
+                auto tmp = *this;
+                --(*this);
+                return tmp;
+            }
+
+            friend bool operator==(const const_iterator &a, const const_iterator &b) { return a._itr == b._itr; }
+            friend bool operator!=(const const_iterator &a, const const_iterator &b) { return a._itr != b._itr; }
+
+        private:
+            friend class multi_index;
+            using map_iterator = typename std::map<uint64_t, row>::const_iterator;
+
+            const_iterator(const std::map<uint64_t, row> *rows, map_iterator itr) : _rows(rows), _itr(itr) {}
+
+            const std::map<uint64_t, row> *_rows = nullptr;
+            map_iterator _itr;
+        };
+
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+        template <size_t I>
+        class index
+        {
+        public:
+            typedef typename index_at<I>::secondary_extractor_type extractor_type;
+            typedef typename extractor_type::result_type secondary_key_type;
+
+            class const_iterator
+            {
+            public:
+                using iterator_category = std::bidirectional_iterator_tag;
+                using value_type = const T;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const T *;
+                using reference = const T &;
+
+                const_iterator() = default;
+
+                const T &operator*() const { return _mi->_storage->rows.at(_entry->second).value; }
+                const T *operator->() const { return &**this; }
+
+                const_iterator &operator++()
+                {
+                    check(_entry.has_value(), "cannot increment end iterator");
+                    auto next = set().upper_bound(*_entry);
+                    _entry = next == set().end() ? std::nullopt : std::optional(*next);
+                    return *this;
+                }
+                const_iterator operator++(int)
+                {
+                    auto tmp = *this;
+                    ++(*this);
+                    return tmp;
+                }
+                const_iterator &operator--()
+                {
+                    auto &entries = set();
+                    auto pos = _entry ? entries.lower_bound(*_entry) : entries.end();
+                    check(pos != entries.begin(), "cannot decrement iterator at beginning of index");
+                    _entry = *std::prev(pos);
+                    return *this;
+                }
+                const_iterator operator--(int)
+                {
+                    auto tmp = *this;
+                    --(*this);
+                    return tmp;
+                }
+
+                friend bool operator==(const const_iterator &a, const const_iterator &b) { return a._entry == b._entry; }
+                friend bool operator!=(const const_iterator &a, const const_iterator &b) { return !(a == b); }
+
+            private:
+                friend class index;
+                using entry = std::pair<secondary_key_type, uint64_t>;
+
+                const_iterator(const multi_index *mi, std::optional<entry> e) : _mi(mi), _entry(std::move(e)) {}
+
+                const secondary_set<index_at<I>> &set() const { return std::get<I>(_mi->_storage->secondaries); }
+
+                const multi_index *_mi = nullptr;
+                std::optional<entry> _entry;
+            };
+
+            typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+            const_iterator cbegin() const { return make(entries().begin()); }
+            const_iterator begin() const { return cbegin(); }
+            const_iterator cend() const { return const_iterator(_mi, std::nullopt); }
+            const_iterator end() const { return cend(); }
+            const_reverse_iterator rbegin() const { return const_reverse_iterator(cend()); }
+            const_reverse_iterator rend() const { return const_reverse_iterator(cbegin()); }
+
+            const_iterator lower_bound(const secondary_key_type &key) const
+            {
+                return make(entries().lower_bound({key, 0}));
+            }
+
+            const_iterator upper_bound(const secondary_key_type &key) const
+            {
+                auto itr = entries().lower_bound({key, 0});
+                while (itr != entries().end() && itr->first == key)
+                    ++itr;
+                return make(itr);
+            }
+
+            const_iterator find(const secondary_key_type &key) const
+            {
+                auto itr = entries().lower_bound({key, 0});
+                if (itr == entries().end() || itr->first != key)
+                    return cend();
+                return make(itr);
+            }
+
+            const T &get(const secondary_key_type &key, const char *error_msg = "unable to find secondary key") const
+            {
+                auto result = find(key);
+                check(result != cend(), error_msg);
+                return *result;
+            }
+
+            const_iterator iterator_to(const T &obj) const
+            {
+                return const_iterator(_mi, std::pair{extractor_type()(obj), obj.primary_key()});
+            }
+
+            template <typename Lambda>
+            void modify(const_iterator itr, name payer, Lambda &&updater)
+            {
+                check(itr != cend(), "cannot pass end iterator to modify");
+                _mi->modify(*itr, payer, std::forward<Lambda>(updater));
+            }
+
+            const_iterator erase(const_iterator itr)
+            {
+                check(itr != cend(), "cannot pass end iterator to erase");
+                const_iterator next = itr;
+                ++next;
+                _mi->erase(*itr);
+                return next;
+            }
+
+            static constexpr uint64_t name() { return static_cast<uint64_t>(index_at<I>::index_name.value); }
+
+        private:
+            friend class multi_index;
+
+            explicit index(multi_index *mi) : _mi(mi) {}
+
+            const secondary_set<index_at<I>> &entries() const { return std::get<I>(_mi->_storage->secondaries); }
+
+            const_iterator make(typename secondary_set<index_at<I>>::const_iterator itr) const
+            {
+                if (itr == entries().end())
+                    return cend();
+                return const_iterator(_mi, *itr);
+            }
+
+            multi_index *_mi;
+        };
+
+        multi_index(name code, uint64_t scope) : _code(code), _scope(scope), _storage(open_storage(code, scope)) {}
+
+        // Secondary indexes keep a pointer back to their table, so it must not move.
+        multi_index(const multi_index &) = delete;
+        multi_index &operator=(const multi_index &) = delete;
+
+        name get_code() const { return _code; }
+        uint64_t get_scope() const { return _scope; }
+
+        const_iterator cbegin() const { return const_iterator(&_storage->rows, _storage->rows.cbegin()); }
+        const_iterator begin() const { return cbegin(); }
+        const_iterator cend() const { return const_iterator(&_storage->rows, _storage->rows.cend()); }
+        const_iterator end() const { return cend(); }
+        const_reverse_iterator crbegin() const { return const_reverse_iterator(cend()); }
+        const_reverse_iterator rbegin() const { return crbegin(); }
+        const_reverse_iterator crend() const { return const_reverse_iterator(cbegin()); }
+        const_reverse_iterator rend() const { return crend(); }
+
+        const_iterator lower_bound(uint64_t primary) const
+        {
+            return const_iterator(&_storage->rows, _storage->rows.lower_bound(primary));
+        }
+
+        const_iterator upper_bound(uint64_t primary) const
+        {
+            return const_iterator(&_storage->rows, _storage->rows.upper_bound(primary));
+        }
+
+        uint64_t available_primary_key() const
+        {
+            if (_storage->rows.empty())
+                return 0;
+            auto next = _storage->rows.rbegin()->first + 1;
+            check(next != 0, "next primary key in table is at maximum value");
+            return next;
+        }
+
+        template <name::raw IndexName>
+        auto get_index()
+        {
+            return index<index_position<IndexName>()>(this);
+        }
+
+        template <name::raw IndexName>
+        auto get_index() const
+        {
+            return index<index_position<IndexName>()>(const_cast<multi_index *>(this));
+        }
+
+        const_iterator iterator_to(const T &obj) const
+        {
+            auto itr = _storage->rows.find(obj.primary_key());
+            check(itr != _storage->rows.end(), "object passed to iterator_to is not in multi_index");
+            return const_iterator(&_storage->rows, itr);
+        }
+
+        template <typename Lambda>
+        const_iterator emplace(name payer, Lambda &&constructor)
+        {
+            check(_code == host::current_receiver(), "cannot create objects in table of another contract");
+
+            T obj{};
+            constructor(obj);
+
+            auto pk = obj.primary_key();
+            auto inserted = _storage->rows.emplace(pk, row{std::move(obj), payer});
+            check(inserted.second, "could not insert object, most likely a uniqueness constraint was violated");
+
+            insert_secondaries(*_storage, inserted.first->second.value, sequence{});
+            return const_iterator(&_storage->rows, inserted.first);
+        }
+
+        template <typename Lambda>
+        void modify(const_iterator itr, name payer, Lambda &&updater)
+        {
+            check(itr != end(), "cannot pass end iterator to modify");
+            modify(*itr, payer, std::forward<Lambda>(updater));
+        }
+
+        template <typename Lambda>
+        void modify(const T &obj, name payer, Lambda &&updater)
+        {
+            check(_code == host::current_receiver(), "cannot modify objects in table of another contract");
+
+            auto itr = _storage->rows.find(obj.primary_key());
+            check(itr != _storage->rows.end(), "object passed to modify is not in multi_index");
+
+            auto &mutable_row = const_cast<row &>(itr->second);
+            auto pk = mutable_row.value.primary_key();
+
+            erase_secondaries(mutable_row.value, sequence{});
+            updater(mutable_row.value);
+            check(pk == mutable_row.value.primary_key(), "updater cannot change primary key when modifying an object");
+            insert_secondaries(*_storage, mutable_row.value, sequence{});
+
+            if (payer != same_payer)
+                mutable_row.payer = payer;
+        }
+
+        const T &get(uint64_t primary, const char *error_msg = "unable to find key") const
+        {
+            auto result = find(primary);
+            check(result != cend(), error_msg);
+            return *result;
+        }
+
+        const_iterator find(uint64_t primary) const
+        {
+            return const_iterator(&_storage->rows, _storage->rows.find(primary));
+        }
+
+        const_iterator require_find(uint64_t primary, const char *error_msg = "unable to find key") const
+        {
+            auto result = find(primary);
+            check(result != cend(), error_msg);
+            return result;
+        }
+
+        const_iterator erase(const_iterator itr)
+        {
+            check(itr != end(), "cannot pass end iterator to erase");
+            auto next = itr;
+            ++next;
+            erase(*itr);
+            return next;
+        }
+
+        void erase(const T &obj)
+        {
+            check(_code == host::current_receiver(), "cannot erase objects in table of another contract");
+
+            auto itr = _storage->rows.find(obj.primary_key());
+            check(itr != _storage->rows.end(), "object passed to erase is not in multi_index");
+
+            erase_secondaries(itr->second.value, sequence{});
+            _storage->rows.erase(itr);
+        }
+
+        // Host-only: number of rows currently stored (handy for benchmark assertions).
+        size_t size() const { return _storage->rows.size(); }
+    };
+
+} // namespace eosio
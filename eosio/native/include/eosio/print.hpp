@@ -0,0 +1,20 @@
+#pragma once
+
+#include <iostream>
+#include <utility>
+
+namespace eosio
+{
+
+    // Console output is dropped on the host unless DHS_NATIVE_PRINT is defined.
+    template <typename... Args>
+    void print(Args &&...args)
+    {
+#ifdef DHS_NATIVE_PRINT
+        (std::cout << ... << std::forward<Args>(args));
+#else
+        ((void)args, ...);
+#endif
+    }
+
+} // namespace eosio
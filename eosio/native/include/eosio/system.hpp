@@ -0,0 +1,16 @@
+#pragma once
+
+#include "host.hpp"
+#include "name.hpp"
+#include "time.hpp"
+
+namespace eosio
+{
+
+    inline time_point current_time_point() { return time_point(microseconds(host::state().now_us)); }
+
+    inline time_point_sec current_time_point_sec() { return time_point_sec(current_time_point().sec_since_epoch()); }
+
+    inline bool is_account(name n) { return host::state().missing_accounts.count(n.value) == 0; }
+
+} // namespace eosio
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+namespace eosio
+{
+
+    class microseconds
+    {
+    public:
+        explicit constexpr microseconds(int64_t c = 0) : _count(c) {}
+        constexpr int64_t count() const { return _count; }
+        constexpr int64_t to_seconds() const { return _count / 1000000; }
+
+        int64_t _count;
+    };
+
+    inline constexpr microseconds seconds(int64_t s) { return microseconds(s * 1000000); }
+
+    class time_point
+    {
+    public:
+        explicit constexpr time_point(microseconds e = microseconds()) : elapsed(e) {}
+        constexpr const microseconds &time_since_epoch() const { return elapsed; }
+        constexpr uint32_t sec_since_epoch() const { return uint32_t(elapsed.count() / 1000000); }
+
+        microseconds elapsed;
+    };
+
+    class time_point_sec
+    {
+    public:
+        constexpr time_point_sec() : utc_seconds(0) {}
+        constexpr explicit time_point_sec(uint32_t seconds) : utc_seconds(seconds) {}
+        constexpr uint32_t sec_since_epoch() const { return utc_seconds; }
+
+        uint32_t utc_seconds;
+    };
+
+} // namespace eosio
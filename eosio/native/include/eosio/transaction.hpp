@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "host.hpp"
+
+namespace eosio
+{
+
+    inline uint32_t tapos_block_prefix() { return host::state().tapos_prefix; }
+
+    inline uint32_t tapos_block_num() { return 0; }
+
+    inline size_t transaction_size() { return host::state().transaction.size(); }
+
+    inline size_t read_transaction(char *buffer, size_t size)
+    {
+        const auto &tx = host::state().transaction;
+        auto copied = size < tx.size() ? size : tx.size();
+        std::memcpy(buffer, tx.data(), copied);
+        return copied;
+    }
+
+} // namespace eosio
@@ -0,0 +1,500 @@
+import "../../../server/common/env";
+import fs from "fs";
+import path from "path";
+import eoslime from "eoslime";
+import { Account } from "eoslime/types/account";
+import { Contract } from "eoslime/types/contract";
+import { SHA256 } from "crypto-js";
+
+// Path to .wasm and .abi smart contract compilation output files (not versioned, rebuilt from the sources by `npm run compile:contracts`).
+const DHS_TOKEN_WASM_PATH = "./compiled/dhstoken.wasm";
+const DHS_TOKEN_ABI_PATH = "./compiled/dhstoken.abi";
+const DHS_SERVICE_WASM_PATH = "./compiled/dhsservice.wasm";
+const DHS_SERVICE_ABI_PATH = "./compiled/dhsservice.abi";
+const DHS_ESCROW_WASM_PATH = "./compiled/dhsescrow.wasm";
+const DHS_ESCROW_ABI_PATH = "./compiled/dhsescrow.abi";
+
+// Committed baseline of the resources billed for each action.
+const BASELINE_PATH = path.join(__dirname, "baseline.json");
+
+// Constants.
+const MAX_SUPPLY = "1000000000.0000 DHS";
+const FIRST_ISSUE = "1000000.0000 DHS";
+const WELCOME_BONUS_USER = "1000.0000 DHS";
+const PRICE = "10.0000 DHS";
+const STAKE = "30.0000 DHS";
+const DEALER_LOCK = "40.0000 DHS"; // Price plus stake.
+const SUMMARY = "Short summary of the request.";
+const JURORS = 6; // Enough jurors for the default panel of three.
+const DEADLINE_DELAY = 30 * 24 * 3600; // Seconds from now.
+const POLL_INTERVAL = 50; // Milliseconds between two reads of the head block.
+const POLL_TIMEOUT = 10000; // Milliseconds before giving up on a transaction block.
+
+// Resources billed for an action.
+interface Resources {
+  cpu_usage_us: number; // Billed CPU in microseconds (median of the samples).
+  net_usage: number; // Billed NET in bytes (max of the samples).
+  ram_delta: number; // RAM delta in bytes of the contracts and of the signer (max of the samples).
+}
+
+interface ActionBaseline extends Resources {
+  samples: number; // Number of measured actions.
+  tolerance?: Partial<Resources>; // Per-action override of the baseline tolerance.
+}
+
+interface Baseline {
+  scale: number; // Lifecycles per path (accept and dispute) the baseline has been recorded with.
+  tolerance: Resources; // Allowed increase over the baseline value, as a fraction of it (the budget).
+  actions: { [action: string]: ActionBaseline };
+}
+
+const METRICS: (keyof Resources)[] = ["cpu_usage_us", "net_usage", "ram_delta"];
+
+// Command line options: "--scale <lifecycles>" and "--update-baseline".
+const updateBaseline = process.argv.includes("--update-baseline");
+const scaleOption = process.argv.indexOf("--scale");
+
+const median = (values: number[]) => {
+  const sorted = values.slice().sort((a, b) => a - b);
+  const middle = Math.floor(sorted.length / 2);
+
+  return sorted.length % 2 === 1
+    ? sorted[middle]
+    : Math.round((sorted[middle - 1] + sorted[middle]) / 2);
+};
+
+const run = async () => {
+  const baseline: Baseline = JSON.parse(
+    fs.readFileSync(BASELINE_PATH, "utf8")
+  );
+  const scale =
+    scaleOption >= 0
+      ? parseInt(process.argv[scaleOption + 1], 10)
+      : baseline.scale;
+
+  if (!(scale > 0)) {
+    throw new Error("Invalid --scale value");
+  }
+
+  // Until the budgets are recorded the run only reports the measured resources.
+  const recorded = Object.keys(baseline.actions).length > 0;
+
+  // Costs grow with the size of the tables, so only runs at the same scale can be compared.
+  if (!updateBaseline && recorded && scale !== baseline.scale) {
+    throw new Error(
+      `Baseline recorded with --scale ${baseline.scale}, update it to compare runs with --scale ${scale}`
+    );
+  }
+
+  // Init eoslime for a local node.
+  const eoslimeInstance = eoslime.init({
+    url: process.env.EOSIO_TEST_URL,
+    chainId: process.env.EOSIO_TEST_CHAIN_ID,
+  });
+
+  // Eosio default account (nb. THE PRIVATE KEY IS KNOWN AND SHOULD NOT BE USED IN PRODUCTION).
+  const eosioDefaultAccount = eoslimeInstance.Account.load(
+    "eosio",
+    "5KQwrPbwdL6PhXujxW37FSSQZ1JiwsST4cqQzDeyXtP79zkvFD3",
+    "active"
+  );
+
+  // Deploy the contracts and create the DHS token.
+  const dhsTokenAccount = await eoslimeInstance.Account.createFromName(
+    "dhstoken",
+    eosioDefaultAccount
+  );
+  const dhsServiceAccount = await eoslimeInstance.Account.createFromName(
+    "dhsservice",
+    eosioDefaultAccount
+  );
+  const dhsEscrowAccount = await eoslimeInstance.Account.createFromName(
+    "dhsescrow",
+    eosioDefaultAccount
+  );
+
+  const dhsTokenContract = await eoslimeInstance.Contract.deployOnAccount(
+    DHS_TOKEN_WASM_PATH,
+    DHS_TOKEN_ABI_PATH,
+    dhsTokenAccount
+  );
+  const dhsServiceContract = await eoslimeInstance.Contract.deployOnAccount(
+    DHS_SERVICE_WASM_PATH,
+    DHS_SERVICE_ABI_PATH,
+    dhsServiceAccount
+  );
+  await eoslimeInstance.Contract.deployOnAccount(
+    DHS_ESCROW_WASM_PATH,
+    DHS_ESCROW_ABI_PATH,
+    dhsEscrowAccount
+  );
+
+  // Add permissions for sending inline actions from the contracts.
+  await dhsTokenAccount.addPermission("eosio.code");
+  await dhsServiceAccount.addPermission("eosio.code");
+  await dhsEscrowAccount.addPermission("eosio.code");
+
+  await dhsTokenContract.actions.create([dhsTokenAccount.name, MAX_SUPPLY], {
+    from: dhsTokenAccount,
+  });
+  await dhsTokenContract.actions.issue(
+    [dhsTokenAccount.name, FIRST_ISSUE, "Token issuing"],
+    { from: dhsTokenAccount }
+  );
+
+  // Samples of the billed resources for each action.
+  const samples: { [action: string]: Resources[] } = {};
+  const contractAccounts = [
+    dhsTokenAccount.name,
+    dhsServiceAccount.name,
+    dhsEscrowAccount.name,
+  ];
+
+  const ramUsage = async (accounts: string[]) => {
+    let total = 0;
+
+    for (const account of accounts) {
+      const info = await dhsServiceContract.provider.eos.getAccount(account);
+      total += info.ram_usage;
+    }
+
+    return total;
+  };
+
+  // Wait until the block of a transaction is the head block, so the tables read next reflect the transaction.
+  const waitForBlock = async (tx: any) => {
+    const deadline = Date.now() + POLL_TIMEOUT;
+
+    while (
+      (await dhsServiceContract.provider.eos.getInfo({})).head_block_num <
+      tx.processed.block_num
+    ) {
+      if (Date.now() > deadline) {
+        throw new Error(`Block ${tx.processed.block_num} not produced`);
+      }
+
+      await new Promise((resolve) => setTimeout(resolve, POLL_INTERVAL));
+    }
+  };
+
+  // Push an action, recording its billed CPU and NET and the RAM delta of the contracts and of the signer.
+  const measure = async (
+    label: string,
+    contract: Contract,
+    action: string,
+    params: any[],
+    from: Account
+  ) => {
+    const accounts = contractAccounts.concat(from.name);
+    const ramBefore = await ramUsage(accounts);
+    const tx = await (contract.actions as any)[action](params, { from });
+    const ramAfter = await ramUsage(accounts);
+
+    samples[label] = samples[label] || [];
+    samples[label].push({
+      cpu_usage_us: tx.processed.receipt.cpu_usage_us,
+      net_usage: tx.processed.net_usage,
+      ram_delta: ramAfter - ramBefore,
+    });
+
+    return tx;
+  };
+
+  // Register the jurors.
+  const jurors = await eoslimeInstance.Account.createRandoms(
+    JURORS,
+    eosioDefaultAccount
+  );
+
+  for (const juror of jurors) {
+    await measure(
+      "signup (juror)",
+      dhsServiceContract,
+      "signup",
+      [juror.name, 1, SHA256(juror.name).toString()],
+      juror
+    );
+  }
+
+  // Drive a digital handshake from the signup of its users to the acceptance of the job or the resolution of a dispute.
+  const lifecycle = async (withDispute: boolean) => {
+    const [dealer, bidder] = await eoslimeInstance.Account.createRandoms(
+      2,
+      eosioDefaultAccount
+    );
+    const deadline = Math.floor(Date.now() / 1000) + DEADLINE_DELAY;
+
+    for (const user of [dealer, bidder]) {
+      await measure(
+        "signup",
+        dhsServiceContract,
+        "signup",
+        [user.name, 0, SHA256(user.name).toString()],
+        user
+      );
+      await dhsTokenContract.actions.transfer(
+        [
+          dhsTokenAccount.name,
+          user.name,
+          WELCOME_BONUS_USER,
+          "Welcome Bonus",
+        ],
+        { from: dhsTokenAccount }
+      );
+    }
+
+    const postTx = await measure(
+      "postrequest",
+      dhsServiceContract,
+      "postrequest",
+      [
+        dealer.name,
+        SUMMARY,
+        SHA256(`${dealer.name} terms`).toString(),
+        PRICE,
+        deadline,
+      ],
+      dealer
+    );
+
+    // Wait for the request to be reflected on the chain.
+    await waitForBlock(postTx);
+    const id = (await dhsServiceContract.tables.reqcounter.find())[0].last_id;
+
+    await measure(
+      "propose",
+      dhsServiceContract,
+      "propose",
+      [bidder.name, id],
+      bidder
+    );
+    await measure(
+      "selectbidder",
+      dhsServiceContract,
+      "selectbidder",
+      [dealer.name, bidder.name, id],
+      dealer
+    );
+    await measure(
+      "negotiate",
+      dhsServiceContract,
+      "negotiate",
+      [
+        bidder.name,
+        id,
+        SHA256(`${bidder.name} terms`).toString(),
+        PRICE,
+        deadline,
+      ],
+      bidder
+    );
+
+    // The bidder has proposed the last round, so the dealer accepts first.
+    await measure(
+      "acceptterms",
+      dhsServiceContract,
+      "acceptterms",
+      [dealer.name, id],
+      dealer
+    );
+    await measure(
+      "acceptterms",
+      dhsServiceContract,
+      "acceptterms",
+      [bidder.name, id],
+      bidder
+    );
+
+    // Lock the tokens (transfer to dhsservice, forwarded to the escrow).
+    await measure(
+      "lock",
+      dhsTokenContract,
+      "transfer",
+      [dealer.name, dhsServiceAccount.name, DEALER_LOCK, `${id}`],
+      dealer
+    );
+    await measure(
+      "lock",
+      dhsTokenContract,
+      "transfer",
+      [bidder.name, dhsServiceAccount.name, STAKE, `${id}`],
+      bidder
+    );
+
+    await measure(
+      "endjob",
+      dhsServiceContract,
+      "endjob",
+      [bidder.name, id],
+      bidder
+    );
+
+    if (!withDispute) {
+      await measure(
+        "acceptjob",
+        dhsServiceContract,
+        "acceptjob",
+        [dealer.name, id],
+        dealer
+      );
+      return;
+    }
+
+    await measure(
+      "opendispute",
+      dhsServiceContract,
+      "opendispute",
+      [dealer.name, id],
+      dealer
+    );
+    await measure(
+      "motivate",
+      dhsServiceContract,
+      "motivate",
+      [dealer.name, id, SHA256(`${dealer.name} motivation`).toString()],
+      dealer
+    );
+    const motivateTx = await measure(
+      "motivate",
+      dhsServiceContract,
+      "motivate",
+      [bidder.name, id, SHA256(`${bidder.name} motivation`).toString()],
+      bidder
+    );
+
+    // Wait for the dispute to be reflected on the chain.
+    await waitForBlock(motivateTx);
+    const panel: string[] = (
+      await dhsServiceContract.tables.disputes.equal(id).find()
+    )[0].jurors;
+
+    // The last vote of the panel also settles the dispute, so it is measured apart.
+    for (let i = 0; i < panel.length; i++) {
+      await measure(
+        i === panel.length - 1 ? "vote (resolve)" : "vote",
+        dhsServiceContract,
+        "vote",
+        [panel[i], id, dealer.name],
+        jurors.filter((juror) => juror.name === panel[i])[0]
+      );
+    }
+  };
+
+  for (let i = 0; i < scale; i++) {
+    await lifecycle(false);
+    await lifecycle(true);
+  }
+
+  // Summarize the samples of each action.
+  const measured: { [action: string]: ActionBaseline } = {};
+
+  Object.keys(samples).forEach((action) => {
+    const values = samples[action];
+
+    measured[action] = {
+      samples: values.length,
+      cpu_usage_us: median(values.map((value) => value.cpu_usage_us)),
+      net_usage: Math.max(...values.map((value) => value.net_usage)),
+      ram_delta: Math.max(...values.map((value) => value.ram_delta)),
+    };
+  });
+
+  if (updateBaseline) {
+    // Keep the tolerance overrides of the actions.
+    Object.keys(measured).forEach((action) => {
+      const previous = baseline.actions[action];
+
+      if (previous && previous.tolerance) {
+        measured[action].tolerance = previous.tolerance;
+      }
+    });
+
+    fs.writeFileSync(
+      BASELINE_PATH,
+      JSON.stringify(
+        { scale, tolerance: baseline.tolerance, actions: measured },
+        null,
+        2
+      ) + "\n"
+    );
+
+    console.table(measured);
+    console.log(`===== Baseline updated (${BASELINE_PATH}) =====`);
+    return 0;
+  }
+
+  // Without any recorded budget there is nothing to compare against, so the run is not a gate yet.
+  if (!recorded) {
+    console.table(measured);
+    console.log(
+      "===== No budget recorded, record the baseline with `npm run bench:eosio-baseline` ====="
+    );
+    return 0;
+  }
+
+  // Compare every action against its budget (an action without a budget, or no longer measured, fails the run).
+  const report: any[] = [];
+  let exceeded = 0;
+
+  Object.keys(baseline.actions)
+    .filter((action) => !measured[action])
+    .forEach((action) => {
+      exceeded++;
+      report.push({ action, status: "NOT MEASURED" });
+    });
+
+  Object.keys(measured).forEach((action) => {
+    const reference = baseline.actions[action];
+
+    METRICS.forEach((metric) => {
+      if (!reference) {
+        exceeded++;
+        report.push({
+          action,
+          metric,
+          measured: measured[action][metric],
+          status: "NO BASELINE",
+        });
+        return;
+      }
+
+      const tolerance =
+        reference.tolerance?.[metric] ?? baseline.tolerance[metric];
+      const budget = Math.floor(
+        reference[metric] + Math.abs(reference[metric]) * tolerance
+      );
+      const overBudget = measured[action][metric] > budget;
+
+      if (overBudget) {
+        exceeded++;
+      }
+
+      report.push({
+        action,
+        metric,
+        measured: measured[action][metric],
+        baseline: reference[metric],
+        budget,
+        status: overBudget ? "OVER BUDGET" : "ok",
+      });
+    });
+  });
+
+  console.table(report);
+  console.log(
+    exceeded > 0
+      ? `===== ${exceeded} budgets exceeded or missing =====`
+      : "===== All budgets respected ====="
+  );
+
+  return exceeded > 0 ? 1 : 0;
+};
+
+console.log("===== Start lifecycle benchmark =====");
+
+run()
+  .then((code) => process.exit(code))
+  .catch((e) => {
+    console.error(e);
+    process.exit(1);
+  });
@@ -6,7 +6,7 @@ import { Contract } from "eoslime/types/contract";
 import { FromQuery } from "eoslime/types/table-reader";
 import { SHA256 } from "crypto-js";
 
-// Path to .wasm and .abi smart contract compilation output files.
+// Path to .wasm and .abi smart contract compilation output files (not versioned, rebuilt from the sources by `npm run compile:contracts`).
 const DHS_TOKEN_WASM_PATH = "./compiled/dhstoken.wasm";
 const DHS_TOKEN_ABI_PATH = "./compiled/dhstoken.abi";
 const DHS_SERVICE_WASM_PATH = "./compiled/dhsservice.wasm";
@@ -14,6 +14,18 @@ const DHS_SERVICE_ABI_PATH = "./compiled/dhsservice.abi";
 const DHS_ESCROW_WASM_PATH = "./compiled/dhsescrow.wasm";
 const DHS_ESCROW_ABI_PATH = "./compiled/dhsescrow.abi";
 
+// Path to the .wasm and .abi files of the previous dhsservice contract version (stores the rows migrated by `migratehash`).
+const DHS_SERVICE_LEGACY_WASM_PATH =
+  "./tests/eosio/fixtures/legacy/dhsservice.wasm";
+const DHS_SERVICE_LEGACY_ABI_PATH =
+  "./tests/eosio/fixtures/legacy/dhsservice.abi";
+
+// Path to the .wasm and .abi files of the previous dhsescrow contract version (stores the balances migrated by `migratelocks`).
+const DHS_ESCROW_LEGACY_WASM_PATH =
+  "./tests/eosio/fixtures/legacy/dhsescrow.wasm";
+const DHS_ESCROW_LEGACY_ABI_PATH =
+  "./tests/eosio/fixtures/legacy/dhsescrow.abi";
+
 // Init eoslime for a local node.
 const eoslimeInstance = eoslime.init({
   url: process.env.EOSIO_TEST_URL,
@@ -53,10 +65,292 @@ describe("Digital Handshake dApp Smart Contracts", () => {
   let usersTable: FromQuery;
   let jurorsTable: FromQuery;
   let requestsTable: FromQuery;
+  let proposalsTable: FromQuery;
   let handshakesTable: FromQuery;
-  let negotiationsTable: FromQuery;
+  let roundsTable: FromQuery;
   let disputesTable: FromQuery;
   let lockedBalanceTable: FromQuery;
+  let requestCounterTable: FromQuery;
+  let jurorSlotsTable: FromQuery;
+  let jurorPoolTable: FromQuery;
+  let assignmentsTable: FromQuery;
+  let statsTable: FromQuery;
+  let escrowStatsTable: FromQuery;
+
+  // Primary key of the negotiation rounds table for a given handshake and round.
+  const roundKey = (dhsId: number, round: number) => dhsId * 2 ** 32 + round;
+
+  // Decimal string of a composite index key, given its [value, shift] parts (the keys exceed the safe integers).
+  const compositeKey = (...parts: [number, number][]) => {
+    // Little endian decimal digits.
+    const sum = (a: number[], b: number[]) => {
+      const digits: number[] = [];
+      let carry = 0;
+
+      for (let i = 0; i < Math.max(a.length, b.length) || carry; i++) {
+        const digit = (a[i] || 0) + (b[i] || 0) + carry;
+
+        digits.push(digit % 10);
+        carry = Math.floor(digit / 10);
+      }
+
+      return digits;
+    };
+    let key = [0];
+
+    parts.forEach(([value, shift]) => {
+      let term = String(value).split("").reverse().map(Number);
+
+      for (let i = 0; i < shift; i++) {
+        term = sum(term, term);
+      }
+
+      key = sum(key, term);
+    });
+
+    return key.reverse().join("").replace(/^0+(?=\d)/, "");
+  };
+
+  // Rows of a dhsservice table read through an index, in index order (the bounds are inclusive).
+  const indexRows = async (
+    table: string,
+    indexPosition: number,
+    keyType: string,
+    lowerBound?: string,
+    upperBound?: string
+  ) =>
+    (
+      await dhsServiceContract.provider.eos.getTableRows({
+        json: true,
+        code: dhsServiceContract.name,
+        scope: dhsServiceContract.name,
+        table,
+        index_position: indexPosition,
+        key_type: keyType,
+        lower_bound: lowerBound,
+        upper_bound: upperBound,
+        limit: 1000,
+      })
+    ).rows;
+
+  // [value, shift] parts of an account name in a composite index key (the 64 bits of the name start from the given shift).
+  const nameParts = (name: string, shift: number) =>
+    name
+      .split("")
+      .map((char, i): [number, number] => [
+        char == "." ? 0 : char <= "5" ? Number(char) : char.charCodeAt(0) - 91,
+        shift + 59 - 5 * i,
+      ]);
+
+  // Check that an index lists every row of its table once, ordered by the given key (compared field by field).
+  const assertIndexOrder = async (
+    table: string,
+    indexPosition: number,
+    keyType: string,
+    key: (row: any) => (number | string)[]
+  ) => {
+    const compare = (a: (number | string)[], b: (number | string)[]) => {
+      const field = a.findIndex((value, i) => value != b[i]);
+
+      return field < 0 ? 0 : a[field] < b[field] ? -1 : 1;
+    };
+    const keys = (await indexRows(table, indexPosition, keyType)).map(key);
+    const primaryKeys = (await indexRows(table, 1, "i64")).map(key);
+
+    assert.deepEqual(
+      keys,
+      [...keys].sort(compare),
+      `Incorrect ${table} index ${indexPosition} order`
+    );
+    assert.deepEqual(
+      keys,
+      primaryKeys.sort(compare),
+      `Incorrect ${table} index ${indexPosition} entries`
+    );
+  };
+
+  // Rows of an index keyed by (account name, identifier), for the given account.
+  const rowsOfName = (table: string, indexPosition: number, name: string) =>
+    indexRows(
+      table,
+      indexPosition,
+      "i128",
+      compositeKey(...nameParts(name, 64)),
+      compositeKey(...nameParts(name, 64), [2 ** 32 - 1, 0])
+    );
+
+  // Slot of a juror, read through the `byjuror` index of the juror pool.
+  const jurorSlotOf = (juror: string) => {
+    const key = compositeKey(...nameParts(juror, 0));
+
+    return indexRows("jurorslots", 2, "i64", key, key);
+  };
+
+  // Check the `bystatus`, `bydealer` and `bydeadline` indexes of the requests.
+  const assertRequestIndexes = async () => {
+    await assertIndexOrder("requests", 2, "i64", (row) => [row.status, row.id]);
+    await assertIndexOrder("requests", 3, "i128", (row) => [
+      row.dealer,
+      row.id,
+    ]);
+    await assertIndexOrder("requests", 4, "i64", (row) => [
+      row.deadline,
+      row.id,
+    ]);
+  };
+
+  // Check the `bydealer`, `bybidder` and `bystatusdl` indexes of the handshakes.
+  const assertHandshakeIndexes = async () => {
+    await assertIndexOrder("handshakes", 2, "i128", (row) => [
+      row.dealer,
+      row.request_id,
+    ]);
+    await assertIndexOrder("handshakes", 3, "i128", (row) => [
+      row.bidder,
+      row.request_id,
+    ]);
+    await assertIndexOrder("handshakes", 4, "i128", (row) => [
+      row.status,
+      row.deadline,
+      row.request_id,
+    ]);
+  };
+
+  // Check the `byrequest` and `bybidder` indexes of the proposals.
+  const assertProposalIndexes = async () => {
+    await assertIndexOrder("proposals", 2, "i128", (row) => [
+      row.request_id,
+      row.bidder,
+    ]);
+    await assertIndexOrder("proposals", 3, "i128", (row) => [
+      row.bidder,
+      row.request_id,
+    ]);
+  };
+
+  // Identifiers of the handshakes in the given status, read through the `bystatusdl` index.
+  const handshakesByStatus = async (status: number) =>
+    (
+      await indexRows(
+        "handshakes",
+        4,
+        "i128",
+        compositeKey([status, 64]),
+        compositeKey([status + 1, 64])
+      )
+    ).map((row) => row.request_id);
+
+  // Identifiers of the requests in the given status, read through the `bystatus` index.
+  const requestsByStatus = async (status: number) =>
+    (
+      await indexRows(
+        "requests",
+        2,
+        "i64",
+        String(status * 2 ** 32),
+        String((status + 1) * 2 ** 32 - 1)
+      )
+    ).map((row) => row.id);
+
+  // Data of the inline actions with the given name sent by a transaction (e.g. the `logbatch` notifications).
+  const inlineActions = (tx: any, name: string) => {
+    const data: any[] = [];
+    const visit = (traces: any[]) =>
+      traces.forEach((trace) => {
+        if (trace.act.name == name) {
+          data.push(trace.act.data);
+        }
+
+        visit(trace.inline_traces || []);
+      });
+
+    visit(tx.processed.action_traces);
+
+    return data;
+  };
+
+  // Create a handshake in execution status between the given users for the given deadline, returning its identifier.
+  const createRunningHandshake = async (
+    dealer: Account,
+    bidder: Account,
+    deadline: number
+  ) => {
+    await dhsServiceContract.actions.postrequest(
+      [
+        dealer.name,
+        "Summary of a running request",
+        SHA256("Running terms").toString(),
+        "10.0000 DHS",
+        deadline,
+      ],
+      { from: dealer }
+    );
+
+    const handshakeId = (await requestCounterTable.find())[0].last_id;
+
+    await dhsServiceContract.actions.propose([bidder.name, handshakeId], {
+      from: bidder,
+    });
+    await dhsServiceContract.actions.selectbidder(
+      [dealer.name, bidder.name, handshakeId],
+      { from: dealer }
+    );
+    await dhsServiceContract.actions.acceptterms([bidder.name, handshakeId], {
+      from: bidder,
+    });
+    await dhsServiceContract.actions.acceptterms([dealer.name, handshakeId], {
+      from: dealer,
+    });
+    await dhsTokenContract.actions.transfer(
+      [dealer.name, dhsServiceAccount.name, "40.0000 DHS", `${handshakeId}`],
+      { from: dealer }
+    );
+    await dhsTokenContract.actions.transfer(
+      [bidder.name, dhsServiceAccount.name, "30.0000 DHS", `${handshakeId}`],
+      { from: bidder }
+    );
+
+    return handshakeId;
+  };
+
+  // Bring a new handshake between the given users to a dispute, returning the dispute.
+  const createDispute = async (dealer: Account, bidder: Account) => {
+    const id = await createRunningHandshake(
+      dealer,
+      bidder,
+      Math.floor(Date.now() * 0.001) + 30 * 24 * 3600
+    );
+
+    await dhsServiceContract.actions.endjob([bidder.name, id], {
+      from: bidder,
+    });
+    await dhsServiceContract.actions.opendispute([dealer.name, id], {
+      from: dealer,
+    });
+
+    return (await disputesTable.equal(id).find())[0];
+  };
+
+  // Users read through the `byrating` index (ordered by rating, then by username).
+  const usersByRating = () => indexRows("users", 2, "i128");
+
+  // Check that the users are listed by rating, then by username, once each.
+  const assertRatingOrder = async (expectedLast: string[]) => {
+    const users = await usersByRating();
+    const registered = await usersTable.find();
+    const keys = users.map((user) => [user.rating, user.info.username]);
+    const sorted = [...keys].sort((a, b) =>
+      a[0] != b[0] ? a[0] - b[0] : a[1] < b[1] ? -1 : 1
+    );
+
+    assert.equal(users.length, registered.length, "Incorrect index entries");
+    assert.deepEqual(keys, sorted, "Incorrect rating order");
+    assert.deepEqual(
+      users.slice(-expectedLast.length).map((user) => user.info.username),
+      expectedLast,
+      "Incorrect highest ratings"
+    );
+  };
 
   // Costants.
   const MAX_SUPPLY = "1000000000.0000 DHS";
@@ -171,6 +465,21 @@ describe("Digital Handshake dApp Smart Contracts", () => {
 
       assert.equal(issuerBalance[0], FIRST_ISSUE, "Incorrect balance");
     }).timeout(3000);
+
+    it("Should fail to transfer tokens to many accounts with an empty list", async () => {
+      try {
+        // Call smart contract action.
+        await dhsTokenContract.actions.transfermany(
+          [dhsTokenAccount.name, [], "Empty transfer"],
+          { from: dhsTokenAccount }
+        );
+      } catch (e) {
+        assert.isTrue(
+          e.includes("assertion failure with message: no transfers"),
+          "Expected an exception but none was received"
+        );
+      }
+    }).timeout(3000);
   }).timeout(5000);
 
   describe("# User Registration (Dealers / Bidders)", async () => {
@@ -194,17 +503,24 @@ describe("Digital Handshake dApp Smart Contracts", () => {
       usersTable = dhsServiceContract.tables.users;
       jurorsTable = dhsServiceContract.tables.jurors;
       requestsTable = dhsServiceContract.tables.requests;
+      proposalsTable = dhsServiceContract.tables.proposals;
       handshakesTable = dhsServiceContract.tables.handshakes;
-      negotiationsTable = dhsServiceContract.tables.negotiations;
+      roundsTable = dhsServiceContract.tables.rounds;
       disputesTable = dhsServiceContract.tables.disputes;
-      lockedBalanceTable = dhsEscrowContract.tables.locked;
+      lockedBalanceTable = dhsEscrowContract.tables.ledger;
+      requestCounterTable = dhsServiceContract.tables.reqcounter;
+      jurorSlotsTable = dhsServiceContract.tables.jurorslots;
+      jurorPoolTable = dhsServiceContract.tables.jurorpool;
+      assignmentsTable = dhsServiceContract.tables.assignments;
+      statsTable = dhsServiceContract.tables.stats;
+      escrowStatsTable = dhsEscrowContract.tables.stats;
     });
 
     it("It should not be possible to register a user given an invalid role", async () => {
       // Call smart contract action.
       try {
         await dhsServiceContract.actions.signup(
-          [testAccount1.name, 2, "wrong sha256"],
+          [testAccount1.name, 2, SHA256(testAccount1.name).toString()],
           { from: testAccount1 }
         );
       } catch (e) {
@@ -219,7 +535,7 @@ describe("Digital Handshake dApp Smart Contracts", () => {
       // Call smart contract action.
       try {
         await dhsServiceContract.actions.signup(
-          [testAccount1.name, 0, "wrong sha256"],
+          [testAccount1.name, 0, "0".repeat(64)],
           { from: testAccount1 }
         );
       } catch (e) {
@@ -250,7 +566,7 @@ describe("Digital Handshake dApp Smart Contracts", () => {
         // Call smart contract action.
         try {
           await dhsServiceContract.actions.signup(
-            [dealer1.name, 0, SHA256(dealer1.name)],
+            [dealer1.name, 0, SHA256(dealer1.name).toString()],
             { from: dealer2 }
           );
         } catch (e) {
@@ -264,12 +580,14 @@ describe("Digital Handshake dApp Smart Contracts", () => {
       it("Should it be possible to register a user", async () => {
         // Call smart contract action.
         await dhsServiceContract.actions.signup(
-          [dealer1.name, 0, SHA256(dealer1.name)],
+          [dealer1.name, 0, SHA256(dealer1.name).toString()],
           { from: dealer1 }
         );
 
-        // Get table information.
+        // Get table information (the first action of a fresh contract marks the hash migration as done).
         const user = await usersTable.equal(dealer1.name).find();
+        const stats = await statsTable.find();
+        const migration = await dhsServiceContract.tables.hashmigr.find();
 
         assert.equal(
           user[0].info.username,
@@ -277,9 +595,11 @@ describe("Digital Handshake dApp Smart Contracts", () => {
           "Incorrect account name"
         );
         assert.equal(user[0].rating, 0, "Incorrect rating");
+        assert.equal(stats[0].users, 1, "Incorrect registered users");
+        assert.equal(migration[0].step, 5, "Incorrect migration step");
         assert.equal(
           user[0].info.external_data_hash,
-          SHA256(dealer1.name),
+          SHA256(dealer1.name).toString(),
           "Incorrect external data hash"
         );
       }).timeout(3000);
@@ -309,7 +629,7 @@ describe("Digital Handshake dApp Smart Contracts", () => {
         // Call smart contract action.
         try {
           await dhsServiceContract.actions.signup(
-            [dealer1.name, 0, SHA256(dealer1.name)],
+            [dealer1.name, 0, SHA256(dealer1.name).toString()],
             { from: dealer1 }
           );
         } catch (e) {
@@ -342,7 +662,7 @@ describe("Digital Handshake dApp Smart Contracts", () => {
         // Call smart contract action.
         try {
           await dhsServiceContract.actions.signup(
-            [juror1.name, 1, SHA256(juror1.name)],
+            [juror1.name, 1, SHA256(juror1.name).toString()],
             { from: juror2 }
           );
         } catch (e) {
@@ -356,7 +676,7 @@ describe("Digital Handshake dApp Smart Contracts", () => {
       it("Should it be possible to register a juror", async () => {
         // Call smart contract action.
         await dhsServiceContract.actions.signup(
-          [juror1.name, 1, SHA256(juror1.name)],
+          [juror1.name, 1, SHA256(juror1.name).toString()],
           { from: juror1 }
         );
 
@@ -370,7 +690,7 @@ describe("Digital Handshake dApp Smart Contracts", () => {
         );
         assert.equal(
           juror[0].info.external_data_hash,
-          SHA256(juror1.name),
+          SHA256(juror1.name).toString(),
           "Incorrect external data hash"
         );
       }).timeout(3000);
@@ -379,7 +699,7 @@ describe("Digital Handshake dApp Smart Contracts", () => {
         // Call smart contract action.
         try {
           await dhsServiceContract.actions.signup(
-            [juror1.name, 1, SHA256(juror1.name)],
+            [juror1.name, 1, SHA256(juror1.name).toString()],
             { from: juror1 }
           );
         } catch (e) {
@@ -391,6 +711,82 @@ describe("Digital Handshake dApp Smart Contracts", () => {
           );
         }
       }).timeout(3000);
+
+      it("Should it be possible to add a registered juror to the juror pool", async () => {
+        // Get table information.
+        const slot = await jurorSlotsTable.equal(0).find();
+        const pool = await jurorPoolTable.find();
+
+        assert.equal(slot[0].juror, juror1.name, "Incorrect juror slot");
+        assert.equal(pool[0].size, 1, "Incorrect juror pool size");
+      }).timeout(3000);
+
+      it("It should not be possible to unregister a juror without the authority", async () => {
+        // Call smart contract action.
+        try {
+          await dhsServiceContract.actions.unregjuror([juror1.name], {
+            from: juror2,
+          });
+        } catch (e) {
+          assert.isTrue(
+            e.includes("missing_auth_exception"),
+            "Expected an exception but none was received"
+          );
+        }
+      }).timeout(3000);
+
+      it("It should not be possible to unregister a juror if the sender is not registered", async () => {
+        // Call smart contract action.
+        try {
+          await dhsServiceContract.actions.unregjuror([juror2.name], {
+            from: juror2,
+          });
+        } catch (e) {
+          assert.isTrue(
+            e.includes(
+              "assertion failure with message: unregjuror: JUROR NOT REGISTERED"
+            ),
+            "Expected an exception but none was received"
+          );
+        }
+      }).timeout(3000);
+
+      it("Should it be possible to unregister a juror", async () => {
+        // Call smart contract action.
+        await dhsServiceContract.actions.unregjuror([juror1.name], {
+          from: juror1,
+        });
+
+        // Get table information.
+        const juror = await jurorsTable.equal(juror1.name).find();
+        const slot = await jurorSlotsTable.equal(0).find();
+        const pool = await jurorPoolTable.find();
+
+        assert.equal(juror.length, 0, "Incorrect juror");
+        assert.equal(slot.length, 0, "Incorrect juror slot");
+        assert.equal(pool[0].size, 0, "Incorrect juror pool size");
+        assert.equal(
+          (await jurorSlotOf(juror1.name)).length,
+          0,
+          "Incorrect juror index"
+        );
+
+        // Register the juror again for the next tests.
+        await dhsServiceContract.actions.signup(
+          [juror1.name, 1, SHA256(juror1.name).toString()],
+          { from: juror1 }
+        );
+      }).timeout(3000);
+
+      it("Should it be possible to find the juror slot through the juror index", async () => {
+        // Get table information.
+        const slot = await jurorSlotOf(juror1.name);
+
+        await assertIndexOrder("jurorslots", 2, "i64", (row) => [row.juror]);
+        assert.equal(slot.length, 1, "Incorrect juror index");
+        assert.equal(slot[0].juror, juror1.name, "Incorrect juror slot");
+        assert.equal(slot[0].slot, 0, "Incorrect juror slot");
+      }).timeout(3000);
     }).timeout(5000);
   }).timeout(5000);
 
@@ -408,12 +804,12 @@ describe("Digital Handshake dApp Smart Contracts", () => {
 
       // Record users.
       await dhsServiceContract.actions.signup(
-        [smallBalanceDealer.name, 0, SHA256(smallBalanceDealer.name)],
+        [smallBalanceDealer.name, 0, SHA256(smallBalanceDealer.name).toString()],
         { from: smallBalanceDealer }
       );
 
       await dhsServiceContract.actions.signup(
-        [smallBalanceBidder.name, 0, SHA256(smallBalanceBidder.name)],
+        [smallBalanceBidder.name, 0, SHA256(smallBalanceBidder.name).toString()],
         { from: smallBalanceBidder }
       );
 
@@ -441,24 +837,24 @@ describe("Digital Handshake dApp Smart Contracts", () => {
 
     describe("# Negotiation", () => {
       const summary = "Short summary of the request.";
-      const contractualTermsHash = SHA256("Contractual Terms hash");
+      const contractualTermsHash = SHA256("Contractual Terms hash").toString();
       const price = "10.0000 DHS";
       const deadline = 1624312800; // 2021 June 22.
 
       before(async () => {
         // Users registration.
         await dhsServiceContract.actions.signup(
-          [dealer2.name, 0, SHA256(dealer2.name)],
+          [dealer2.name, 0, SHA256(dealer2.name).toString()],
           { from: dealer2 }
         );
 
         await dhsServiceContract.actions.signup(
-          [bidder1.name, 0, SHA256(bidder1.name)],
+          [bidder1.name, 0, SHA256(bidder1.name).toString()],
           { from: bidder1 }
         );
 
         await dhsServiceContract.actions.signup(
-          [bidder2.name, 0, SHA256(bidder2.name)],
+          [bidder2.name, 0, SHA256(bidder2.name).toString()],
           { from: bidder2 }
         );
 
@@ -603,7 +999,7 @@ describe("Digital Handshake dApp Smart Contracts", () => {
           // Call smart contract action.
           try {
             await dhsServiceContract.actions.postrequest(
-              [dealer1.name, summary, "", price, deadline],
+              [dealer1.name, summary, "0".repeat(64), price, deadline],
               { from: dealer1 }
             );
           } catch (e) {
@@ -657,7 +1053,81 @@ describe("Digital Handshake dApp Smart Contracts", () => {
           assert.equal(request[0].price, price, "Incorrect price");
           assert.equal(request[0].deadline, deadline, "Incorrect deadline");
           assert.equal(request[0].status, 0, "Incorrect status");
-          assert.equal(request[0].bidders.length, 0, "Incorrect bidder array");
+        }).timeout(3000);
+
+        it("Should it be possible to keep track of the last request identifier", async () => {
+          // Get table information (Should it be the identifier of the first request).
+          const counter = await requestCounterTable.find();
+
+          assert.equal(counter[0].last_id, 1, "Incorrect last request id");
+        }).timeout(3000);
+
+        it("Should it be possible to find the request through the secondary indexes", async () => {
+          // Get table information through the `bydealer` and `bydeadline` indexes.
+          const byDealer = await rowsOfName("requests", 3, dealer1.name);
+          const fromDeadline = await indexRows(
+            "requests",
+            4,
+            "i64",
+            compositeKey([deadline, 32])
+          );
+          const afterDeadline = await indexRows(
+            "requests",
+            4,
+            "i64",
+            compositeKey([deadline + 1, 32])
+          );
+
+          await assertRequestIndexes();
+          assert.deepEqual(await requestsByStatus(0), [1], "Incorrect open");
+          assert.deepEqual(await requestsByStatus(1), [], "Incorrect closed");
+          assert.deepEqual(
+            byDealer.map((row) => row.id),
+            [1],
+            "Incorrect dealer requests"
+          );
+          assert.deepEqual(
+            fromDeadline.map((row) => row.id),
+            [1],
+            "Incorrect requests from the deadline"
+          );
+          assert.deepEqual(
+            afterDeadline.map((row) => row.id),
+            [],
+            "Incorrect requests after the deadline"
+          );
+        }).timeout(3000);
+
+        it("It should not be possible to seed the request counter twice", async () => {
+          // Call smart contract action.
+          try {
+            await dhsServiceContract.actions.seedreqid([], {
+              from: dhsServiceAccount,
+            });
+          } catch (e) {
+            assert.isTrue(
+              e.includes(
+                "assertion failure with message: seedreqid: COUNTER ALREADY SEEDED"
+              ),
+              "Expected an exception but none was received"
+            );
+          }
+        }).timeout(3000);
+
+        it("It should not be possible to migrate the hashes given zero max rows", async () => {
+          // Call smart contract action.
+          try {
+            await dhsServiceContract.actions.migratehash([0], {
+              from: dhsServiceAccount,
+            });
+          } catch (e) {
+            assert.isTrue(
+              e.includes(
+                "assertion failure with message: migratehash: INVALID MAX ROWS"
+              ),
+              "Expected an exception but none was received"
+            );
+          }
         }).timeout(3000);
       }).timeout(5000);
 
@@ -736,15 +1206,36 @@ describe("Digital Handshake dApp Smart Contracts", () => {
             from: bidder1,
           });
 
-          // Get table information (Should it be the first request).
-          const request = await requestsTable.equal(requestId).find();
+          // Get table information (Should it be the first proposal).
+          const proposals = (await proposalsTable.find()).filter(
+            (proposal) => proposal.request_id === requestId
+          );
 
-          assert.equal(request[0].id, requestId, "Incorrect id");
-          assert.equal(request[0].bidders.length, 1, "Incorrect bidders array");
-          assert.equal(
-            request[0].bidders[0],
-            bidder1.name,
-            "Incorrect bidders array"
+          assert.equal(proposals.length, 1, "Incorrect proposals");
+          assert.equal(proposals[0].bidder, bidder1.name, "Incorrect bidder");
+        }).timeout(3000);
+
+        it("Should it be possible to find the proposal through the secondary indexes", async () => {
+          // Get table information through the `byrequest` and `bybidder` indexes.
+          const byRequest = await indexRows(
+            "proposals",
+            2,
+            "i128",
+            compositeKey([requestId, 64]),
+            compositeKey([requestId + 1, 64])
+          );
+          const byBidder = await rowsOfName("proposals", 3, bidder1.name);
+
+          await assertProposalIndexes();
+          assert.deepEqual(
+            byRequest.map((row) => row.bidder),
+            [bidder1.name],
+            "Incorrect request proposals"
+          );
+          assert.deepEqual(
+            byBidder.map((row) => row.request_id),
+            [requestId],
+            "Incorrect bidder proposals"
           );
         }).timeout(3000);
 
@@ -766,6 +1257,39 @@ describe("Digital Handshake dApp Smart Contracts", () => {
             );
           }
         }).timeout(3000);
+
+        it("It should not be possible to batch propose for an empty list of requests", async () => {
+          // Call smart contract action.
+          try {
+            await dhsServiceContract.actions.batchpropose([bidder1.name, []], {
+              from: bidder1,
+            });
+          } catch (e) {
+            assert.isTrue(
+              e.includes(
+                "assertion failure with message: batchpropose: INVALID BATCH SIZE"
+              ),
+              "Expected an exception but none was received"
+            );
+          }
+        }).timeout(3000);
+
+        it("Should it be possible to batch propose without aborting on the failed requests", async () => {
+          // Call smart contract action (the bidder already proposed for the first request, the second one does not exist).
+          await dhsServiceContract.actions.batchpropose(
+            [bidder1.name, [requestId, 999]],
+            {
+              from: bidder1,
+            }
+          );
+
+          // Get table information (Should it be still the first proposal only).
+          const proposals = (await proposalsTable.find()).filter(
+            (proposal) => proposal.bidder === bidder1.name
+          );
+
+          assert.equal(proposals.length, 1, "Incorrect proposals");
+        }).timeout(3000);
       });
 
       describe("# Select Bidder", () => {
@@ -879,7 +1403,6 @@ describe("Digital Handshake dApp Smart Contracts", () => {
           // Get tables information.
           const request = await requestsTable.equal(requestId).find();
           const handshake = await handshakesTable.equal(requestId).find();
-          const negotiation = await negotiationsTable.equal(requestId).find();
 
           assert.equal(request[0].id, requestId, "Incorrect id");
           assert.equal(request[0].bidder, bidder1.name, "Incorrect bidder");
@@ -889,21 +1412,71 @@ describe("Digital Handshake dApp Smart Contracts", () => {
           assert.equal(handshake[0].bidder, bidder1.name, "Incorrect bidder");
           assert.equal(handshake[0].status, 0, "Incorrect status");
 
-          assert.equal(negotiation[0].dhs_id, requestId, "Incorrect id");
+          const round = await roundsTable.equal(roundKey(requestId, 0)).find();
+
+          assert.equal(handshake[0].request_id, requestId, "Incorrect id");
+          assert.equal(handshake[0].rounds, 1, "Incorrect rounds");
           assert.equal(
-            negotiation[0].proposed_contractual_terms_hashes[0],
+            handshake[0].contractual_terms_hash,
             request[0].contractual_terms_hash,
             "Incorrect contractual terms hash"
           );
+          assert.equal(handshake[0].price, request[0].price, "Incorrect price");
+          assert.equal(
+            handshake[0].deadline,
+            request[0].deadline,
+            "Incorrect deadline"
+          );
+
+          assert.equal(round[0].dhs_id, requestId, "Incorrect round id");
+          assert.equal(round[0].round, 0, "Incorrect round");
           assert.equal(
-            negotiation[0].proposed_prices,
-            request[0].price,
-            "Incorrect price"
+            round[0].contractual_terms_hash,
+            request[0].contractual_terms_hash,
+            "Incorrect round contractual terms hash"
           );
+          assert.equal(round[0].price, request[0].price, "Incorrect round price");
           assert.equal(
-            negotiation[0].proposed_deadlines,
+            round[0].deadline,
             request[0].deadline,
-            "Incorrect deadline"
+            "Incorrect round deadline"
+          );
+        }).timeout(3000);
+
+        it("Should it be possible to find the handshake through the secondary indexes", async () => {
+          // Get table information through the `bydealer` and `bybidder` indexes.
+          const byDealer = await rowsOfName("handshakes", 2, dealer1.name);
+          const byBidder = await rowsOfName("handshakes", 3, bidder1.name);
+
+          await assertHandshakeIndexes();
+          assert.include(
+            byDealer.map((row) => row.request_id),
+            requestId,
+            "Incorrect dealer handshakes"
+          );
+          assert.include(
+            byBidder.map((row) => row.request_id),
+            requestId,
+            "Incorrect bidder handshakes"
+          );
+          assert.include(
+            await handshakesByStatus(0),
+            requestId,
+            "Incorrect handshakes in negotiation"
+          );
+        }).timeout(3000);
+
+        it("Should it be possible to find the closed request through the status index", async () => {
+          await assertRequestIndexes();
+          assert.notInclude(
+            await requestsByStatus(0),
+            requestId,
+            "Incorrect open requests"
+          );
+          assert.include(
+            await requestsByStatus(1),
+            requestId,
+            "Incorrect closed requests"
           );
         }).timeout(3000);
 
@@ -1023,7 +1596,7 @@ describe("Digital Handshake dApp Smart Contracts", () => {
           // Call smart contract action.
           try {
             await dhsServiceContract.actions.negotiate(
-              [bidder1.name, id, "", price, deadline],
+              [bidder1.name, id, "0".repeat(64), price, deadline],
               { from: bidder1 }
             );
           } catch (e) {
@@ -1146,24 +1719,27 @@ describe("Digital Handshake dApp Smart Contracts", () => {
             );
 
             // Get tables information.
-            const negotiation = await negotiationsTable.equal(id).find();
+            const handshake = await handshakesTable.equal(id).find();
+            const round = await roundsTable.equal(roundKey(id, 1)).find();
 
-            assert.equal(negotiation[0].dhs_id, id, "Incorrect id");
+            assert.equal(handshake[0].request_id, id, "Incorrect id");
+            assert.equal(handshake[0].rounds, 2, "Incorrect rounds");
             assert.equal(
-              negotiation[0].proposed_contractual_terms_hashes[1],
+              handshake[0].contractual_terms_hash,
               proposedContractualTermsHash,
               "Incorrect contractual terms hash"
             );
+            assert.equal(handshake[0].price, price, "Incorrect price");
+            assert.equal(handshake[0].deadline, deadline, "Incorrect deadline");
+
+            assert.equal(round[0].round, 1, "Incorrect round");
             assert.equal(
-              negotiation[0].proposed_prices[1],
-              price,
-              "Incorrect price"
-            );
-            assert.equal(
-              negotiation[0].proposed_deadlines[1],
-              deadline,
-              "Incorrect deadline"
+              round[0].contractual_terms_hash,
+              proposedContractualTermsHash,
+              "Incorrect round contractual terms hash"
             );
+            assert.equal(round[0].price, price, "Incorrect round price");
+            assert.equal(round[0].deadline, deadline, "Incorrect round deadline");
           }).timeout(3000);
         });
 
@@ -1213,24 +1789,27 @@ describe("Digital Handshake dApp Smart Contracts", () => {
             );
 
             // Get tables information.
-            const negotiation = await negotiationsTable.equal(id).find();
+            const handshake = await handshakesTable.equal(id).find();
+            const round = await roundsTable.equal(roundKey(id, 2)).find();
 
-            assert.equal(negotiation[0].dhs_id, id, "Incorrect id");
+            assert.equal(handshake[0].request_id, id, "Incorrect id");
+            assert.equal(handshake[0].rounds, 3, "Incorrect rounds");
             assert.equal(
-              negotiation[0].proposed_contractual_terms_hashes[2],
+              handshake[0].contractual_terms_hash,
               proposedContractualTermsHash,
               "Incorrect contractual terms hash"
             );
+            assert.equal(handshake[0].price, price, "Incorrect price");
+            assert.equal(handshake[0].deadline, deadline, "Incorrect deadline");
+
+            assert.equal(round[0].round, 2, "Incorrect round");
             assert.equal(
-              negotiation[0].proposed_prices[2],
-              price,
-              "Incorrect price"
-            );
-            assert.equal(
-              negotiation[0].proposed_deadlines[2],
-              deadline,
-              "Incorrect deadline"
+              round[0].contractual_terms_hash,
+              proposedContractualTermsHash,
+              "Incorrect round contractual terms hash"
             );
+            assert.equal(round[0].price, price, "Incorrect round price");
+            assert.equal(round[0].deadline, deadline, "Incorrect round deadline");
           }).timeout(3000);
         });
       });
@@ -1333,12 +1912,11 @@ describe("Digital Handshake dApp Smart Contracts", () => {
             });
 
             // Get tables information.
-            const negotiation = await negotiationsTable.equal(id).find();
             const handshake = await handshakesTable.equal(id).find();
 
-            assert.equal(negotiation[0].dhs_id, id, "Incorrect id");
+            assert.equal(handshake[0].request_id, id, "Incorrect id");
             assert.equal(
-              negotiation[0].accepted_by_bidder,
+              handshake[0].accepted_by_bidder,
               true,
               "Incorrect bidder boolean"
             );
@@ -1373,28 +1951,30 @@ describe("Digital Handshake dApp Smart Contracts", () => {
             });
 
             // Get tables information.
-            const negotiation = await negotiationsTable.equal(id).find();
             const handshake = await handshakesTable.equal(id).find();
+            const lastRound = await roundsTable
+              .equal(roundKey(id, handshake[0].rounds - 1))
+              .find();
 
-            assert.equal(negotiation[0].dhs_id, id, "Incorrect id");
+            assert.equal(handshake[0].request_id, id, "Incorrect id");
             assert.equal(
-              negotiation[0].accepted_by_dealer,
+              handshake[0].accepted_by_dealer,
               true,
               "Incorrect dealer boolean"
             );
             assert.equal(
               handshake[0].contractual_terms_hash,
-              negotiation[0].proposed_contractual_terms_hashes[2],
+              lastRound[0].contractual_terms_hash,
               "Incorrect handshake contractual terms hash"
             );
             assert.equal(
               handshake[0].price,
-              negotiation[0].proposed_prices[2],
+              lastRound[0].price,
               "Incorrect handshake price"
             );
             assert.equal(
               handshake[0].deadline,
-              negotiation[0].proposed_deadlines[2],
+              lastRound[0].deadline,
               "Incorrect handshake deadline"
             );
             assert.equal(handshake[0].status, 1, "Incorrect handshake status");
@@ -1440,6 +2020,25 @@ describe("Digital Handshake dApp Smart Contracts", () => {
             }
           }).timeout(3000);
 
+          it("It should not be possible to lock tokens if the memo is not an handshake identifier", async () => {
+            // Call smart contract action.
+            try {
+              await dhsTokenContract.actions.transfer(
+                [dealer1.name, dhsServiceAccount.name, "1.0000 DHS", "1a"],
+                {
+                  from: dealer1,
+                }
+              );
+            } catch (e) {
+              assert.isTrue(
+                e.includes(
+                  "assertion failure with message: notifylock: INVALID MEMO"
+                ),
+                "Expected an exception but none was received"
+              );
+            }
+          }).timeout(3000);
+
           it("It should not be possible to lock tokens if the handshake does not exist", async () => {
             // Call smart contract action.
             try {
@@ -1528,35 +2127,44 @@ describe("Digital Handshake dApp Smart Contracts", () => {
               );
 
               // Get tables information.
-              const negotiation = await negotiationsTable.equal(id).find();
-              const lockedBalance = await lockedBalanceTable
-                .equal(dealer1.name)
-                .find();
+              const handshake = await handshakesTable.equal(id).find();
+              const lockedBalance = await lockedBalanceTable.equal(id).find();
+              const escrowStats = await escrowStatsTable.find();
 
-              assert.equal(negotiation[0].dhs_id, id, "Incorrect id");
+              assert.equal(handshake[0].request_id, id, "Incorrect id");
               assert.equal(
-                negotiation[0].accepted_by_dealer,
+                handshake[0].accepted_by_dealer,
                 true,
                 "Incorrect dealer boolean"
               );
               assert.equal(
-                negotiation[0].accepted_by_bidder,
+                handshake[0].accepted_by_bidder,
                 true,
                 "Incorrect bidder boolean"
               );
               assert.equal(
-                negotiation[0].lock_by_dealer,
+                handshake[0].lock_by_dealer,
                 true,
                 "Incorrect dealer lock boolean"
               );
+              assert.equal(
+                escrowStats[0].total_locked,
+                dealerLockAmount,
+                "Incorrect escrow total locked"
+              );
+              assert.equal(
+                escrowStats[0].open_locks,
+                1,
+                "Incorrect escrow open locks"
+              );
 
               assert.equal(
-                lockedBalance[0].user,
+                lockedBalance[0].dealer,
                 dealer1.name,
                 "Incorrect escrow locked balance user"
               );
               assert.equal(
-                lockedBalance[0].funds,
+                lockedBalance[0].dealer_funds,
                 dealerLockAmount,
                 "Incorrect escrow locked balance funds"
               );
@@ -1631,25 +2239,22 @@ describe("Digital Handshake dApp Smart Contracts", () => {
               );
 
               // Get tables information.
-              const negotiation = await negotiationsTable.equal(id).find();
               const handshake = await handshakesTable.equal(id).find();
-              const lockedBalance = await lockedBalanceTable
-                .equal(bidder1.name)
-                .find();
+              const lockedBalance = await lockedBalanceTable.equal(id).find();
 
-              assert.equal(negotiation[0].dhs_id, id, "Incorrect id");
+              assert.equal(handshake[0].request_id, id, "Incorrect id");
               assert.equal(
-                negotiation[0].accepted_by_dealer,
+                handshake[0].accepted_by_dealer,
                 true,
                 "Incorrect dealer boolean"
               );
               assert.equal(
-                negotiation[0].accepted_by_bidder,
+                handshake[0].accepted_by_bidder,
                 true,
                 "Incorrect bidder boolean"
               );
               assert.equal(
-                negotiation[0].lock_by_bidder,
+                handshake[0].lock_by_bidder,
                 true,
                 "Incorrect bidder lock boolean"
               );
@@ -1660,17 +2265,46 @@ describe("Digital Handshake dApp Smart Contracts", () => {
               );
 
               assert.equal(
-                lockedBalance[0].user,
+                lockedBalance[0].bidder,
                 bidder1.name,
                 "Incorrect escrow locked balance user"
               );
               assert.equal(
-                lockedBalance[0].funds,
+                lockedBalance[0].bidder_funds,
                 bidderLockAmount,
                 "Incorrect escrow locked balance funds"
               );
             }).timeout(3000);
 
+            it("Should it be possible to find the handshake in execution through the status index", async () => {
+              const handshake = await handshakesTable.equal(id).find();
+
+              // Get table information from the key of the handshake onward.
+              const fromHandshake = await indexRows(
+                "handshakes",
+                4,
+                "i128",
+                compositeKey([2, 64], [handshake[0].deadline, 32], [id, 0])
+              );
+
+              await assertHandshakeIndexes();
+              assert.notInclude(
+                await handshakesByStatus(1),
+                id,
+                "Incorrect handshakes in lock"
+              );
+              assert.include(
+                await handshakesByStatus(2),
+                id,
+                "Incorrect handshakes in execution"
+              );
+              assert.equal(
+                fromHandshake[0].request_id,
+                id,
+                "Incorrect status index lower bound"
+              );
+            }).timeout(3000);
+
             it("It should not be possible to accept terms if the handshake is not in lock status", async () => {
               // Call smart contract action.
               try {
@@ -1851,63 +2485,272 @@ describe("Digital Handshake dApp Smart Contracts", () => {
       }).timeout(5000);
 
       describe("# Expired", () => {
-        // TODO.
-      }).timeout(5000);
-
-      describe("# Accept Job", () => {
-        const id = 1;
+        let expiringDeadline: number;
+        let expiringId: number;
+        let runningId: number;
 
         // Some delay for waiting 2 blocks before each test (in order to have the previous state update reflected on the chain).
         beforeEach((done) => setTimeout(done, 1000));
 
-        it("It should not be possible to accept the job without the authority", async () => {
-          // Call smart contract action.
-          try {
-            await dhsServiceContract.actions.acceptjob([dealer1.name, id], {
-              from: dealer2,
-            });
-          } catch (e) {
-            assert.isTrue(
-              e.includes("missing_auth_exception"),
-              "Expected an exception but none was received"
-            );
-          }
-        }).timeout(3000);
+        before(async () => {
+          // A handshake expiring in a few seconds and a handshake still running after the sweep.
+          expiringDeadline = Math.floor(Date.now() * 0.001) + 20;
+          expiringId = await createRunningHandshake(
+            dealer2,
+            bidder2,
+            expiringDeadline
+          );
+          runningId = await createRunningHandshake(
+            dealer2,
+            bidder2,
+            Math.floor(Date.now() * 0.001) + 30 * 24 * 3600
+          );
+        });
 
-        it("It should not be possible to accept the job if the sender is not registered", async () => {
+        it("It should not be possible to unlock the tokens before the deadline", async () => {
           // Call smart contract action.
           try {
-            await dhsServiceContract.actions.acceptjob(
-              [unregisteredUser.name, id],
-              {
-                from: unregisteredUser,
-              }
+            await dhsServiceContract.actions.expired(
+              [dealer2.name, runningId],
+              { from: dealer2 }
             );
           } catch (e) {
             assert.isTrue(
               e.includes(
-                "assertion failure with message: acceptjob: USER NOT REGISTERED"
+                "assertion failure with message: expired: NOT EXPIRED DEADLINE"
               ),
               "Expected an exception but none was received"
             );
           }
         }).timeout(3000);
 
-        it("It should not be possible to accept the job if the handshake does not exist", async () => {
-          // Call smart contract action.
-          try {
-            await dhsServiceContract.actions.acceptjob([dealer1.name, 10], {
-              from: dealer1,
-            });
-          } catch (e) {
-            assert.isTrue(
-              e.includes(
-                "assertion failure with message: acceptjob: HANDSHAKE NOT EXIST"
-              ),
-              "Expected an exception but none was received"
-            );
-          }
-        }).timeout(3000);
+        describe("# Sweep Expired", () => {
+          // Some delay for waiting 2 blocks before each test (in order to have the previous state update reflected on the chain).
+          beforeEach((done) => setTimeout(done, 1000));
+
+          it("It should not be possible to sweep expired handshakes given zero max rows", async () => {
+            // Call smart contract action.
+            try {
+              await dhsServiceContract.actions.sweepexpired([0], {
+                from: unregisteredUser,
+              });
+            } catch (e) {
+              assert.isTrue(
+                e.includes(
+                  "assertion failure with message: sweepexpired: INVALID MAX ROWS"
+                ),
+                "Expected an exception but none was received"
+              );
+            }
+          }).timeout(3000);
+
+          it("It should not be possible to sweep expired handshakes given too many max rows", async () => {
+            // Call smart contract action.
+            try {
+              await dhsServiceContract.actions.sweepexpired([51], {
+                from: unregisteredUser,
+              });
+            } catch (e) {
+              assert.isTrue(
+                e.includes(
+                  "assertion failure with message: sweepexpired: INVALID MAX ROWS"
+                ),
+                "Expected an exception but none was received"
+              );
+            }
+          }).timeout(3000);
+
+          it("Should it be possible to sweep the expired handshakes only", async () => {
+            // Wait for the deadline of the expiring handshake.
+            await new Promise((resolve) =>
+              setTimeout(
+                resolve,
+                Math.max(0, (expiringDeadline + 2) * 1000 - Date.now())
+              )
+            );
+
+            const statsBefore = await statsTable.find();
+            const escrowStatsBefore = await escrowStatsTable.find();
+            const dealerBefore = await dealer2.getBalance(
+              "DHS",
+              dhsTokenContract.name
+            );
+            const bidderBefore = await bidder2.getBalance(
+              "DHS",
+              dhsTokenContract.name
+            );
+
+            // Call smart contract action.
+            await dhsServiceContract.actions.sweepexpired([50], {
+              from: unregisteredUser,
+            });
+
+            // Get tables information.
+            const sweepTime = Math.floor(Date.now() * 0.001);
+            const expiring = await handshakesTable.equal(expiringId).find();
+            const running = await handshakesTable.equal(runningId).find();
+            const handshakes = await handshakesTable.find();
+            const expiringLock = await lockedBalanceTable
+              .equal(expiringId)
+              .find();
+            const runningLock = await lockedBalanceTable
+              .equal(runningId)
+              .find();
+            const stats = await statsTable.find();
+            const escrowStats = await escrowStatsTable.find();
+            const dealerBalance = await dealer2.getBalance(
+              "DHS",
+              dhsTokenContract.name
+            );
+            const bidderBalance = await bidder2.getBalance(
+              "DHS",
+              dhsTokenContract.name
+            );
+            const amount = (asset: string) => parseFloat(asset.split(" ")[0]);
+
+            // The expired handshake is closed and both users get back their tokens.
+            assert.equal(expiring[0].status, 8, "Incorrect expired status");
+            assert.isTrue(
+              expiring[0].unlock_for_expiration_by_dealer &&
+                expiring[0].unlock_for_expiration_by_bidder,
+              "Incorrect unlock booleans"
+            );
+            assert.equal(expiringLock.length, 0, "Incorrect expired ledger");
+            assert.equal(
+              amount(dealerBalance[0]),
+              amount(dealerBefore[0]) + 40,
+              "Incorrect dealer refund"
+            );
+            assert.equal(
+              amount(bidderBalance[0]),
+              amount(bidderBefore[0]) + 30,
+              "Incorrect bidder refund"
+            );
+
+            // The walk stops at the first handshake with a deadline not yet expired.
+            assert.equal(running[0].status, 2, "Incorrect running status");
+            assert.isFalse(
+              running[0].unlock_for_expiration_by_dealer ||
+                running[0].unlock_for_expiration_by_bidder,
+              "Incorrect running unlock booleans"
+            );
+            assert.equal(
+              runningLock[0].dealer_funds,
+              "40.0000 DHS",
+              "Incorrect running dealer funds"
+            );
+            assert.equal(
+              runningLock[0].bidder_funds,
+              "30.0000 DHS",
+              "Incorrect running bidder funds"
+            );
+            handshakes
+              .filter((handshake) => handshake.status == 2)
+              .forEach((handshake) =>
+                assert.isAbove(
+                  handshake.deadline,
+                  sweepTime - 10,
+                  "Incorrect expired handshake left in execution"
+                )
+              );
+
+            // Statistics.
+            const swept = stats[0].handshakes[8] - statsBefore[0].handshakes[8];
+
+            assert.isAtLeast(swept, 1, "Incorrect expired handshakes");
+            assert.equal(
+              stats[0].handshakes[2],
+              statsBefore[0].handshakes[2] - swept,
+              "Incorrect handshakes in execution"
+            );
+            assert.equal(
+              escrowStats[0].open_locks,
+              escrowStatsBefore[0].open_locks - swept,
+              "Incorrect escrow open locks"
+            );
+            assert.isAtMost(
+              amount(escrowStats[0].total_locked),
+              amount(escrowStatsBefore[0].total_locked) - 70,
+              "Incorrect escrow total locked"
+            );
+          }).timeout(60000);
+
+          it("Should it be possible to sweep with nothing expired", async () => {
+            const statsBefore = await statsTable.find();
+
+            // Call smart contract action.
+            await dhsServiceContract.actions.sweepexpired([50], {
+              from: unregisteredUser,
+            });
+
+            // Get tables information.
+            const running = await handshakesTable.equal(runningId).find();
+            const stats = await statsTable.find();
+
+            assert.equal(running[0].status, 2, "Incorrect running status");
+            assert.deepEqual(
+              stats[0].handshakes,
+              statsBefore[0].handshakes,
+              "Incorrect statistics"
+            );
+          }).timeout(3000);
+        });
+      }).timeout(5000);
+
+      describe("# Accept Job", () => {
+        const id = 1;
+
+        // Some delay for waiting 2 blocks before each test (in order to have the previous state update reflected on the chain).
+        beforeEach((done) => setTimeout(done, 1000));
+
+        it("It should not be possible to accept the job without the authority", async () => {
+          // Call smart contract action.
+          try {
+            await dhsServiceContract.actions.acceptjob([dealer1.name, id], {
+              from: dealer2,
+            });
+          } catch (e) {
+            assert.isTrue(
+              e.includes("missing_auth_exception"),
+              "Expected an exception but none was received"
+            );
+          }
+        }).timeout(3000);
+
+        it("It should not be possible to accept the job if the sender is not registered", async () => {
+          // Call smart contract action.
+          try {
+            await dhsServiceContract.actions.acceptjob(
+              [unregisteredUser.name, id],
+              {
+                from: unregisteredUser,
+              }
+            );
+          } catch (e) {
+            assert.isTrue(
+              e.includes(
+                "assertion failure with message: acceptjob: USER NOT REGISTERED"
+              ),
+              "Expected an exception but none was received"
+            );
+          }
+        }).timeout(3000);
+
+        it("It should not be possible to accept the job if the handshake does not exist", async () => {
+          // Call smart contract action.
+          try {
+            await dhsServiceContract.actions.acceptjob([dealer1.name, 10], {
+              from: dealer1,
+            });
+          } catch (e) {
+            assert.isTrue(
+              e.includes(
+                "assertion failure with message: acceptjob: HANDSHAKE NOT EXIST"
+              ),
+              "Expected an exception but none was received"
+            );
+          }
+        }).timeout(3000);
 
         it("It should not be possible to accept the job if the user is not the dealer of the handshake", async () => {
           // Call smart contract action.
@@ -1933,13 +2776,9 @@ describe("Digital Handshake dApp Smart Contracts", () => {
 
           // Get tables information.
           const handshake = await handshakesTable.equal(id).find();
+          const stats = await statsTable.find();
 
-          const lockedBalanceDealer = await lockedBalanceTable
-            .equal(dealer1.name)
-            .find();
-          const lockedBalanceBidder = await lockedBalanceTable
-            .equal(bidder1.name)
-            .find();
+          const lockedBalance = await lockedBalanceTable.equal(id).find();
 
           const dealerBalance = await dealer1.getBalance(
             "DHS",
@@ -1955,24 +2794,14 @@ describe("Digital Handshake dApp Smart Contracts", () => {
 
           assert.equal(handshake[0].status, 6, "Incorrect handshake status");
           assert.equal(
-            lockedBalanceDealer[0].user,
-            dealer1.name,
-            "Incorrect escrow locked balance for dealer"
-          );
-          assert.equal(
-            lockedBalanceDealer[0].funds,
-            "40.0000 DHS",
-            "Incorrect escrow locked balance funds for dealer"
-          );
-          assert.equal(
-            lockedBalanceBidder[0].user,
-            bidder1.name,
-            "Incorrect escrow locked balance for dealer"
+            stats[0].handshakes[6],
+            1,
+            "Incorrect accepted handshakes statistics"
           );
           assert.equal(
-            lockedBalanceBidder[0].funds,
-            "30.0000 DHS",
-            "Incorrect escrow locked balance funds for dealer"
+            lockedBalance.length,
+            0,
+            "Incorrect escrow ledger after settlement"
           );
           assert.equal(
             dealerBalance[0],
@@ -1988,6 +2817,13 @@ describe("Digital Handshake dApp Smart Contracts", () => {
           assert.equal(bidder[0].rating, 1, "Incorrect rating");
         }).timeout(3000);
 
+        it("Should it be possible to list the users by rating after the job acceptance", async () => {
+          // The dealer and the bidder are the only users with a rating (ties ordered by username).
+          await assertRatingOrder(
+            [dealer1.name, bidder1.name].sort((a, b) => (a < b ? -1 : 1))
+          );
+        }).timeout(3000);
+
         it("It should not be possible to accept the job if the handshake is not in confirmation status", async () => {
           // Call smart contract action.
           try {
@@ -2019,23 +2855,23 @@ describe("Digital Handshake dApp Smart Contracts", () => {
 
           // Register the jurors.
           await dhsServiceContract.actions.signup(
-            [juror2.name, 1, SHA256(juror2.name)],
+            [juror2.name, 1, SHA256(juror2.name).toString()],
             { from: juror2 }
           );
           await dhsServiceContract.actions.signup(
-            [juror3.name, 1, SHA256(juror3.name)],
+            [juror3.name, 1, SHA256(juror3.name).toString()],
             { from: juror3 }
           );
           await dhsServiceContract.actions.signup(
-            [juror4.name, 1, SHA256(juror4.name)],
+            [juror4.name, 1, SHA256(juror4.name).toString()],
             { from: juror4 }
           );
           await dhsServiceContract.actions.signup(
-            [juror5.name, 1, SHA256(juror5.name)],
+            [juror5.name, 1, SHA256(juror5.name).toString()],
             { from: juror5 }
           );
           await dhsServiceContract.actions.signup(
-            [juror6.name, 1, SHA256(juror6.name)],
+            [juror6.name, 1, SHA256(juror6.name).toString()],
             { from: juror6 }
           );
         });
@@ -2105,6 +2941,46 @@ describe("Digital Handshake dApp Smart Contracts", () => {
           }
         }).timeout(3000);
 
+        it("It should not be possible to set an even juror panel size", async () => {
+          // Call smart contract action.
+          try {
+            await dhsServiceContract.actions.setpanel([2], {
+              from: dhsServiceAccount,
+            });
+          } catch (e) {
+            assert.isTrue(
+              e.includes(
+                "assertion failure with message: setpanel: INVALID PANEL SIZE"
+              ),
+              "Expected an exception but none was received"
+            );
+          }
+        }).timeout(3000);
+
+        it("It should not be possible to open a dispute if the juror pool is smaller than the panel", async () => {
+          await dhsServiceContract.actions.setpanel([15], {
+            from: dhsServiceAccount,
+          });
+
+          // Call smart contract action.
+          try {
+            await dhsServiceContract.actions.opendispute([dealer1.name, id], {
+              from: dealer1,
+            });
+          } catch (e) {
+            assert.isTrue(
+              e.includes(
+                "assertion failure with message: opendispute: NOT ENOUGH JURORS"
+              ),
+              "Expected an exception but none was received"
+            );
+          }
+
+          await dhsServiceContract.actions.setpanel([3], {
+            from: dhsServiceAccount,
+          });
+        }).timeout(5000);
+
         it("Should it be possible to open a dispute", async () => {
           // Call smart contract action.
           await dhsServiceContract.actions.opendispute([dealer1.name, id], {
@@ -2117,9 +2993,50 @@ describe("Digital Handshake dApp Smart Contracts", () => {
 
           assert.equal(handshake[0].status, 4, "Incorrect handshake status");
           assert.equal(dispute[0].dhs_id, id, "Incorrect dispute handshake id");
-          assert.equal(dispute[0].juror1.length > 0, true, "Incorrect juror1");
-          assert.equal(dispute[0].juror2.length > 0, true, "Incorrect juror2");
-          assert.equal(dispute[0].juror3.length > 0, true, "Incorrect juror3");
+          assert.equal(dispute[0].jurors.length, 3, "Incorrect panel size");
+          assert.equal(
+            new Set(dispute[0].jurors).size,
+            3,
+            "Incorrect distinct jurors"
+          );
+
+          // Every juror of the panel should have an open assignment.
+          const assignments = (await assignmentsTable.find()).filter(
+            (assignment) => assignment.dhs_id === id
+          );
+
+          assert.equal(assignments.length, 3, "Incorrect juror assignments");
+
+          // Every juror of the panel should have a load of one open assignment.
+          const slots = (await jurorSlotsTable.find()).filter((slot) =>
+            dispute[0].jurors.includes(slot.juror)
+          );
+
+          slots.forEach((slot) =>
+            assert.equal(slot.load, 1, "Incorrect juror load")
+          );
+        }).timeout(10000);
+
+        it("Should it be possible to find the assignments through the juror index", async () => {
+          const dispute = await disputesTable.equal(id).find();
+
+          await assertIndexOrder("assignments", 2, "i128", (row) => [
+            row.juror,
+            row.dhs_id,
+          ]);
+          await assertIndexOrder("jurorslots", 2, "i64", (row) => [row.juror]);
+
+          for (const juror of dispute[0].jurors) {
+            const assignments = await rowsOfName("assignments", 2, juror);
+            const slot = await jurorSlotOf(juror);
+
+            assert.include(
+              assignments.map((row) => row.dhs_id),
+              id,
+              "Incorrect juror assignments"
+            );
+            assert.equal(slot[0].load, 1, "Incorrect juror load");
+          }
         }).timeout(10000);
 
         it("It should not be possible to open a dispute if the handshake is not in confirmation status", async () => {
@@ -2143,10 +3060,10 @@ describe("Digital Handshake dApp Smart Contracts", () => {
         const id = 2;
         const dealerMotivationHash = SHA256(
           "Dealer Motivation for Handshake with id 2"
-        );
+        ).toString();
         const bidderMotivationHash = SHA256(
           "Bidder Motivation for Handshake with id 2"
-        );
+        ).toString();
 
         // Some delay for waiting 2 blocks before each test (in order to have the previous state update reflected on the chain).
         beforeEach((done) => setTimeout(done, 1000));
@@ -2225,11 +3142,11 @@ describe("Digital Handshake dApp Smart Contracts", () => {
           }
         }).timeout(3000);
 
-        it("It should not be possible to motivate a dispute if the motivation hash is not a valid sha256", async () => {
+        it("It should not be possible to motivate a dispute if the motivation hash is the zero sha256", async () => {
           // Call smart contract action.
           try {
             await dhsServiceContract.actions.motivate(
-              [dealer1.name, id, "wrong sha"],
+              [dealer1.name, id, "0".repeat(64)],
               {
                 from: dealer1,
               }
@@ -2351,9 +3268,9 @@ describe("Digital Handshake dApp Smart Contracts", () => {
           const dispute = await disputesTable.equal(id).find();
           const jurors = [juror1, juror2, juror3, juror4, juror5, juror6];
           const selectedJurorsNames = [
-            dispute[0].juror1,
-            dispute[0].juror2,
-            dispute[0].juror3,
+            dispute[0].jurors[0],
+            dispute[0].jurors[1],
+            dispute[0].jurors[2],
           ];
 
           jurors.forEach((juror: Account) => {
@@ -2541,8 +3458,13 @@ describe("Digital Handshake dApp Smart Contracts", () => {
             const dispute = await disputesTable.equal(id).find();
 
             assert.equal(
-              dispute[0].vote1,
-              dealer1.name,
+              dispute[0].voted,
+              1,
+              "Incorrect dispute votes after juror1"
+            );
+            assert.equal(
+              dispute[0].votes_for_bidder,
+              0,
               "Incorrect dispute vote for juror1"
             );
           }).timeout(3000);
@@ -2581,8 +3503,13 @@ describe("Digital Handshake dApp Smart Contracts", () => {
             const dispute = await disputesTable.equal(id).find();
 
             assert.equal(
-              dispute[0].vote2,
-              bidder1.name,
+              dispute[0].voted,
+              3,
+              "Incorrect dispute votes after juror2"
+            );
+            assert.equal(
+              dispute[0].votes_for_bidder,
+              2,
               "Incorrect dispute vote for juror2"
             );
           }).timeout(3000);
@@ -2620,12 +3547,8 @@ describe("Digital Handshake dApp Smart Contracts", () => {
             // Get tables information.
             const dispute = await disputesTable.equal(id).find();
             const handshake = await handshakesTable.equal(id).find();
-            const lockedBalanceDealer = await lockedBalanceTable
-              .equal(dealer1.name)
-              .find();
-            const lockedBalanceBidder = await lockedBalanceTable
-              .equal(bidder1.name)
-              .find();
+            const stats = await statsTable.find();
+            const lockedBalance = await lockedBalanceTable.equal(id).find();
             const dealerBalance = await dealer1.getBalance(
               "DHS",
               dhsTokenContract.name
@@ -2650,8 +3573,13 @@ describe("Digital Handshake dApp Smart Contracts", () => {
             const bidder = await usersTable.equal(bidder1.name).find();
 
             assert.equal(
-              dispute[0].vote3,
-              dealer1.name,
+              dispute[0].voted,
+              7,
+              "Incorrect dispute votes after juror3"
+            );
+            assert.equal(
+              dispute[0].votes_for_bidder,
+              2,
               "Incorrect dispute vote for juror3"
             );
 
@@ -2661,24 +3589,14 @@ describe("Digital Handshake dApp Smart Contracts", () => {
               "Incorrect status for handshake"
             );
             assert.equal(
-              lockedBalanceDealer[0].user,
-              dealer1.name,
-              "Incorrect escrow locked balance for dealer"
-            );
-            assert.equal(
-              lockedBalanceDealer[0].funds,
-              "0.0000 DHS",
-              "Incorrect escrow locked balance funds for dealer"
-            );
-            assert.equal(
-              lockedBalanceBidder[0].user,
-              bidder1.name,
-              "Incorrect escrow locked balance for dealer"
+              stats[0].handshakes[7],
+              1,
+              "Incorrect resolved handshakes statistics"
             );
             assert.equal(
-              lockedBalanceBidder[0].funds,
-              "0.0000 DHS",
-              "Incorrect escrow locked balance funds for dealer"
+              lockedBalance.length,
+              0,
+              "Incorrect escrow ledger after settlement"
             );
             assert.equal(dealer[0].rating, 2, "Incorrect rating");
             assert.equal(bidder[0].rating, 0, "Incorrect rating");
@@ -2710,6 +3628,42 @@ describe("Digital Handshake dApp Smart Contracts", () => {
             );
           }).timeout(3000);
 
+          it("Should it be possible to list the users by rating after the dispute resolution", async () => {
+            // The winner dealer is the highest rated user, the loser bidder moves back among the unrated users.
+            await assertRatingOrder([dealer1.name]);
+
+            const users = await usersByRating();
+            const bidder = users.find(
+              (user) => user.info.username == bidder1.name
+            );
+
+            assert.equal(bidder.rating, 0, "Incorrect rating");
+          }).timeout(3000);
+
+          it("Should it be possible to drop the closed assignments from the juror index", async () => {
+            const dispute = await disputesTable.equal(id).find();
+
+            await assertIndexOrder("assignments", 2, "i128", (row) => [
+              row.juror,
+              row.dhs_id,
+            ]);
+            await assertIndexOrder("jurorslots", 2, "i64", (row) => [
+              row.juror,
+            ]);
+
+            for (const juror of dispute[0].jurors) {
+              const assignments = await rowsOfName("assignments", 2, juror);
+              const slot = await jurorSlotOf(juror);
+
+              assert.notInclude(
+                assignments.map((row) => row.dhs_id),
+                id,
+                "Incorrect juror assignments"
+              );
+              assert.equal(slot[0].load, 0, "Incorrect juror load");
+            }
+          }).timeout(10000);
+
           it("It should not be possible to vote if the handshake has not a voting status", async () => {
             // Call smart contract action.
             try {
@@ -2730,6 +3684,1067 @@ describe("Digital Handshake dApp Smart Contracts", () => {
           }).timeout(3000);
         }).timeout(5000);
       }).timeout(5000);
-    });
+
+      describe("# Archive", () => {
+        // Some delay for waiting 2 blocks before each test (in order to have the previous state update reflected on the chain).
+        beforeEach((done) => setTimeout(done, 1000));
+
+        // Identifiers of the archived handshakes.
+        let archivedIds: number[] = [];
+
+        it("It should not be possible to archive handshakes given zero max rows", async () => {
+          // Call smart contract action.
+          try {
+            await dhsServiceContract.actions.archive([0], {
+              from: unregisteredUser,
+            });
+          } catch (e) {
+            assert.isTrue(
+              e.includes(
+                "assertion failure with message: archive: INVALID MAX ROWS"
+              ),
+              "Expected an exception but none was received"
+            );
+          }
+        }).timeout(3000);
+
+        it("It should not be possible to set the retention if not the contract account", async () => {
+          // Call smart contract action.
+          try {
+            await dhsServiceContract.actions.setretention([0], {
+              from: unregisteredUser,
+            });
+          } catch (e) {
+            assert.isTrue(
+              e.includes("missing authority of"),
+              "Expected an exception but none was received"
+            );
+          }
+        }).timeout(3000);
+
+        // Rows of a digital handshake, read through the primary keys and the `byrequest` index.
+        const handshakeRows = async (id: number) => ({
+          handshake: await handshakesTable.equal(id).find(),
+          request: await requestsTable.equal(id).find(),
+          dispute: await disputesTable.equal(id).find(),
+          rounds: await indexRows(
+            "rounds",
+            1,
+            "i64",
+            String(roundKey(id, 0)),
+            String(roundKey(id, 2 ** 32 - 1))
+          ),
+          proposals: await indexRows(
+            "proposals",
+            2,
+            "i128",
+            compositeKey([id, 64]),
+            compositeKey([id + 1, 64])
+          ),
+        });
+
+        // Finished handshakes visited by the archival, in `bystatusdl` order (status, deadline, identifier).
+        const archivable = async () => {
+          const now = Math.floor(Date.now() / 1000);
+          const finished = await indexRows(
+            "handshakes",
+            4,
+            "i128",
+            compositeKey([6, 64]),
+            compositeKey([9, 64])
+          );
+
+          return finished.filter((handshake) => handshake.deadline <= now);
+        };
+
+        it("Should it be possible to resume the archival of a handshake cut by the row budget", async () => {
+          await dhsServiceContract.actions.setretention([0], {
+            from: dhsServiceAccount,
+          });
+
+          const first = (await archivable())[0];
+          const before = await handshakeRows(first.request_id);
+
+          assert.isAtLeast(before.rounds.length, 1, "Incorrect rounds");
+
+          // Call smart contract action (the single row goes to the first round of the first handshake).
+          const tx = await dhsServiceContract.actions.archive([1], {
+            from: unregisteredUser,
+          });
+
+          // Get table information.
+          const after = await handshakeRows(first.request_id);
+
+          assert.equal(after.handshake.length, 1, "Incorrect handshake");
+          assert.equal(
+            after.rounds.length,
+            before.rounds.length - 1,
+            "Incorrect erased rounds"
+          );
+          assert.deepEqual(
+            after.rounds,
+            before.rounds.slice(1),
+            "Incorrect erased round"
+          );
+          assert.deepEqual(
+            after.proposals,
+            before.proposals,
+            "Incorrect proposals"
+          );
+          assert.equal(
+            after.request.length,
+            before.request.length,
+            "Incorrect request"
+          );
+          assert.equal(
+            after.dispute.length,
+            before.dispute.length,
+            "Incorrect dispute"
+          );
+          assert.equal(
+            inlineActions(tx, "logarchive").length,
+            0,
+            "Incorrect archive notifications"
+          );
+        }).timeout(3000);
+
+        it("Should it be possible to archive the finished handshakes after the retention window", async () => {
+          const finished = await archivable();
+          const ids = finished.map((handshake) => handshake.request_id);
+
+          archivedIds = ids;
+          const disputes = await disputesTable.find();
+          const statsBefore = await statsTable.find();
+
+          // The dispute rows must be erased with their handshake.
+          assert.isTrue(
+            disputes.some((dispute) => ids.includes(dispute.dhs_id)),
+            "Incorrect disputed handshakes"
+          );
+
+          // Call smart contract action.
+          const tx = await dhsServiceContract.actions.archive([100], {
+            from: unregisteredUser,
+          });
+
+          // Get table information (No finished handshake with an expired deadline should be left).
+          const logs = inlineActions(tx, "logarchive");
+          const stats = await statsTable.find();
+
+          assert.equal((await archivable()).length, 0, "Incorrect archival");
+          assert.deepEqual(
+            logs.map((log) => log.summary.dhs_id),
+            ids,
+            "Incorrect archive notifications"
+          );
+
+          for (const handshake of finished) {
+            const rows = await handshakeRows(handshake.request_id);
+            const log = logs.find(
+              (entry) => entry.summary.dhs_id == handshake.request_id
+            );
+
+            assert.equal(rows.handshake.length, 0, "Incorrect handshake");
+            assert.equal(rows.request.length, 0, "Incorrect request");
+            assert.equal(rows.dispute.length, 0, "Incorrect dispute");
+            assert.equal(rows.rounds.length, 0, "Incorrect rounds");
+            assert.equal(rows.proposals.length, 0, "Incorrect proposals");
+            assert.equal(log.summary.status, handshake.status, "Incorrect log");
+            assert.equal(log.summary.rounds, handshake.rounds, "Incorrect log");
+            assert.equal(
+              log.summary.disputed,
+              disputes.some(
+                (dispute) => dispute.dhs_id == handshake.request_id
+              ),
+              "Incorrect disputed log"
+            );
+          }
+
+          [6, 7, 8].forEach((status) =>
+            assert.equal(
+              stats[0].handshakes[status],
+              statsBefore[0].handshakes[status] -
+                finished.filter((handshake) => handshake.status == status)
+                  .length,
+              "Incorrect statistics"
+            )
+          );
+        }).timeout(3000);
+
+        it("Should it be possible to drop the archived rows from the secondary indexes", async () => {
+          await assertRequestIndexes();
+          await assertHandshakeIndexes();
+          await assertProposalIndexes();
+
+          for (const status of [0, 1]) {
+            const ids = await requestsByStatus(status);
+
+            archivedIds.forEach((id) =>
+              assert.notInclude(ids, id, "Incorrect archived request")
+            );
+          }
+
+          for (const status of [6, 7, 8]) {
+            const ids = await handshakesByStatus(status);
+
+            archivedIds.forEach((id) =>
+              assert.notInclude(ids, id, "Incorrect archived handshake")
+            );
+          }
+        }).timeout(10000);
+      }).timeout(5000);
+
+      describe("# Juror Draw", () => {
+        let drawDealer: Account;
+        let drawBidder: Account;
+        let drawJuror: Account;
+
+        // Some delay for waiting 2 blocks before each test (in order to have the previous state update reflected on the chain).
+        beforeEach((done) => setTimeout(done, 1000));
+
+        // Open assignments of every juror of the pool, by username.
+        const jurorLoads = async () => {
+          const loads: { [juror: string]: number } = {};
+
+          (await indexRows("jurorslots", 1, "i64")).forEach(
+            (slot) => (loads[slot.juror] = slot.load)
+          );
+
+          return loads;
+        };
+
+        // Check that a panel holds distinct jurors of the pool, none of them a party of the dispute.
+        const assertPanel = (dispute: any, size: number, pool: string[]) => {
+          assert.equal(dispute.jurors.length, size, "Incorrect panel size");
+          assert.equal(
+            new Set(dispute.jurors).size,
+            size,
+            "Incorrect distinct jurors"
+          );
+
+          dispute.jurors.forEach((juror: string) => {
+            assert.include(pool, juror, "Incorrect juror outside the pool");
+            assert.notInclude(
+              [dispute.dealer, dispute.bidder],
+              juror,
+              "Incorrect dispute party in the panel"
+            );
+          });
+        };
+
+        before(async () => {
+          const randomAccounts = await eoslimeInstance.Account.createRandoms(
+            3,
+            eosioDefaultAccount
+          );
+
+          drawDealer = randomAccounts[0];
+          drawBidder = randomAccounts[1];
+          drawJuror = randomAccounts[2];
+
+          for (const user of [drawDealer, drawBidder]) {
+            await dhsServiceContract.actions.signup(
+              [user.name, 0, SHA256(user.name).toString()],
+              { from: user }
+            );
+          }
+
+          // The panel size is odd, so the whole pool can be drawn only from an odd pool.
+          if ((await jurorPoolTable.find())[0].size % 2 == 0) {
+            await dhsServiceContract.actions.signup(
+              [drawJuror.name, 1, SHA256(drawJuror.name).toString()],
+              { from: drawJuror }
+            );
+          }
+        });
+
+        after(async () => {
+          // Restore the default panel size.
+          await dhsServiceContract.actions.setpanel([3], {
+            from: dhsServiceAccount,
+          });
+        });
+
+        it("Should it be possible to draw the whole juror pool", async () => {
+          const pool = Object.keys(await jurorLoads());
+
+          // Call smart contract actions.
+          await dhsServiceContract.actions.setpanel([pool.length], {
+            from: dhsServiceAccount,
+          });
+
+          const dispute = await createDispute(drawDealer, drawBidder);
+
+          assertPanel(dispute, pool.length, pool);
+          assert.sameMembers(dispute.jurors, pool, "Incorrect panel");
+        }).timeout(30000);
+
+        it("Should it be possible to draw a panel smaller than the juror pool", async () => {
+          const loadsBefore = await jurorLoads();
+          const pool = Object.keys(loadsBefore);
+
+          // Call smart contract actions.
+          await dhsServiceContract.actions.setpanel([3], {
+            from: dhsServiceAccount,
+          });
+
+          const dispute = await createDispute(drawDealer, drawBidder);
+
+          // Get table information (Only the panel jurors get a new assignment).
+          const loads = await jurorLoads();
+
+          assert.isAbove(pool.length, 3, "Incorrect juror pool size");
+          assertPanel(dispute, 3, pool);
+          pool.forEach((juror) =>
+            assert.equal(
+              loads[juror],
+              loadsBefore[juror] + (dispute.jurors.includes(juror) ? 1 : 0),
+              "Incorrect juror load"
+            )
+          );
+        }).timeout(30000);
+
+        describe("# Overloaded Jurors", () => {
+          // Loads from which a juror is overloaded (skipped by the draw while enough other jurors are available).
+          const maxJurorLoad = 5;
+          let freshJurors: string[] = [];
+
+          // Some delay for waiting 2 blocks before each test (in order to have the previous state update reflected on the chain).
+          beforeEach((done) => setTimeout(done, 1000));
+
+          // Check that the overloaded jurors of a panel are the least loaded ones.
+          const assertLeastLoaded = (
+            panel: string[],
+            loads: { [juror: string]: number }
+          ) => {
+            const overloaded = Object.keys(loads).filter(
+              (juror) => loads[juror] >= maxJurorLoad
+            );
+            const picked = overloaded.filter((juror) => panel.includes(juror));
+            const skipped = overloaded.filter(
+              (juror) => !panel.includes(juror)
+            );
+
+            assert.isAtMost(
+              Math.max(...picked.map((juror) => loads[juror])),
+              Math.min(...skipped.map((juror) => loads[juror])),
+              "Incorrect overloaded jurors order"
+            );
+          };
+
+          before(async () => {
+            const pool = Object.keys(await jurorLoads());
+
+            // Overload every juror of the pool by drawing it in unvoted disputes.
+            await dhsServiceContract.actions.setpanel([pool.length], {
+              from: dhsServiceAccount,
+            });
+
+            while (
+              Math.min(...Object.values(await jurorLoads())) < maxJurorLoad
+            ) {
+              await createDispute(drawDealer, drawBidder);
+            }
+          });
+
+          it("Should it be possible to draw the least loaded jurors when the whole pool is overloaded", async () => {
+            const loadsBefore = await jurorLoads();
+            const pool = Object.keys(loadsBefore);
+
+            // Call smart contract actions.
+            await dhsServiceContract.actions.setpanel([3], {
+              from: dhsServiceAccount,
+            });
+
+            const dispute = await createDispute(drawDealer, drawBidder);
+
+            // Every slot of the pool is drawn (four candidates for each seat of the panel).
+            assert.isAtMost(pool.length, 3 * 4, "Incorrect juror pool size");
+            assertPanel(dispute, 3, pool);
+            assertLeastLoaded(dispute.jurors, loadsBefore);
+          }).timeout(30000);
+
+          it("Should it be possible to skip the overloaded jurors while enough jurors are available", async () => {
+            const randomAccounts = await eoslimeInstance.Account.createRandoms(
+              3,
+              eosioDefaultAccount
+            );
+
+            // Register jurors without open assignments.
+            for (const juror of randomAccounts) {
+              await dhsServiceContract.actions.signup(
+                [juror.name, 1, SHA256(juror.name).toString()],
+                { from: juror }
+              );
+            }
+
+            freshJurors = randomAccounts.map((juror) => juror.name);
+
+            const pool = Object.keys(await jurorLoads());
+
+            // Call smart contract action.
+            const dispute = await createDispute(drawDealer, drawBidder);
+
+            assert.isAtMost(pool.length, 3 * 4, "Incorrect juror pool size");
+            assertPanel(dispute, 3, pool);
+            assert.sameMembers(dispute.jurors, freshJurors, "Incorrect panel");
+          }).timeout(30000);
+
+          it("Should it be possible to complete the panel with the least loaded overloaded jurors", async () => {
+            const loadsBefore = await jurorLoads();
+            const pool = Object.keys(loadsBefore);
+
+            // Call smart contract actions (more seats than jurors below the maximum load).
+            await dhsServiceContract.actions.setpanel([5], {
+              from: dhsServiceAccount,
+            });
+
+            const dispute = await createDispute(drawDealer, drawBidder);
+
+            assert.isAtMost(pool.length, 5 * 4, "Incorrect juror pool size");
+            assertPanel(dispute, 5, pool);
+            freshJurors.forEach((juror) =>
+              assert.include(dispute.jurors, juror, "Incorrect fresh juror")
+            );
+            assertLeastLoaded(dispute.jurors, loadsBefore);
+          }).timeout(30000);
+        }).timeout(60000);
+      }).timeout(5000);
+
+      describe("# Batch Propose", () => {
+        // Requests posted after the handshake flow, whose tests refer to the request identifiers.
+        const requestIds: { [name: string]: number } = {};
+
+        // Some delay for waiting 2 blocks before each test (in order to have the previous state update reflected on the chain).
+        beforeEach((done) => setTimeout(done, 1000));
+
+        // Post an open request, returning its identifier.
+        const postOpenRequest = async (dealer: Account) => {
+          await dhsServiceContract.actions.postrequest(
+            [
+              dealer.name,
+              "Summary of a batch request",
+              SHA256("Batch terms").toString(),
+              "10.0000 DHS",
+              Math.floor(Date.now() * 0.001) + 30 * 24 * 3600,
+            ],
+            { from: dealer }
+          );
+
+          return (await requestCounterTable.find())[0].last_id;
+        };
+
+        before(async () => {
+          requestIds.proposed = await postOpenRequest(dealer2);
+          requestIds.first = await postOpenRequest(dealer2);
+          requestIds.second = await postOpenRequest(dealer2);
+          requestIds.own = await postOpenRequest(bidder2);
+          requestIds.closed = (await requestsByStatus(1))[0];
+
+          await dhsServiceContract.actions.propose(
+            [bidder2.name, requestIds.proposed],
+            { from: bidder2 }
+          );
+        });
+
+        it("Should it be possible to batch propose the valid requests and log the failed ones", async () => {
+          // Call smart contract action (valid and failing requests interleaved).
+          const tx = await dhsServiceContract.actions.batchpropose(
+            [
+              bidder2.name,
+              [
+                requestIds.first,
+                999,
+                requestIds.proposed,
+                requestIds.closed,
+                requestIds.own,
+                requestIds.second,
+              ],
+            ],
+            { from: bidder2 }
+          );
+
+          // Get table information through the `bybidder` index.
+          const proposals = await rowsOfName("proposals", 3, bidder2.name);
+          const logs = inlineActions(tx, "logbatch");
+
+          assert.includeMembers(
+            proposals.map((proposal) => proposal.request_id),
+            [requestIds.proposed, requestIds.first, requestIds.second],
+            "Incorrect proposals"
+          );
+          assert.notInclude(
+            proposals.map((proposal) => proposal.request_id),
+            requestIds.own,
+            "Incorrect proposal for an own request"
+          );
+          assert.equal(logs.length, 1, "Incorrect batch notifications");
+          assert.equal(logs[0].bidder, bidder2.name, "Incorrect bidder");
+          assert.deepEqual(
+            logs[0].failures,
+            [
+              { request_id: 999, reason: "REQUEST NOT POSTED" },
+              {
+                request_id: requestIds.proposed,
+                reason: "USER ALREADY PROPOSED",
+              },
+              { request_id: requestIds.closed, reason: "REQUEST NOT OPEN" },
+              {
+                request_id: requestIds.own,
+                reason: "REQUEST DEALER CANNOT PROPOSE",
+              },
+            ],
+            "Incorrect batch failures"
+          );
+        }).timeout(3000);
+
+        it("Should it be possible to batch propose without any notification when every request is valid", async () => {
+          const third = await postOpenRequest(dealer2);
+
+          // Call smart contract action.
+          const tx = await dhsServiceContract.actions.batchpropose(
+            [bidder2.name, [third]],
+            { from: bidder2 }
+          );
+
+          // Get table information.
+          const proposals = await rowsOfName("proposals", 3, bidder2.name);
+
+          assert.include(
+            proposals.map((proposal) => proposal.request_id),
+            third,
+            "Incorrect proposals"
+          );
+          assert.equal(
+            inlineActions(tx, "logbatch").length,
+            0,
+            "Incorrect batch notifications"
+          );
+        }).timeout(3000);
+      }).timeout(5000);
+    });
+  }).timeout(5000);
+
+  describe("# Hash Migration", () => {
+    // Account running the previous dhsservice contract version, upgraded to the current one by the tests.
+    let legacyServiceAccount: Account;
+    let legacyServiceContract: Contract;
+    let migratedServiceContract: Contract;
+
+    // Users of the legacy contract.
+    let legacyDealer: Account;
+    let legacyBidder1: Account;
+    let legacyBidder2: Account;
+    let legacyJuror: Account;
+
+    const summary = "Legacy request";
+    const price = "10.0000 DHS";
+    const proposedPrice = "12.0000 DHS";
+    const newPrice = "11.0000 DHS";
+    const deadline = Math.floor(Date.now() * 0.001) + 30 * 24 * 3600;
+    const proposedDeadline = deadline + 24 * 3600;
+    const contractualTermsHash = SHA256("Legacy contractual terms").toString();
+    const proposedContractualTermsHash = SHA256("Legacy proposal").toString();
+    const newContractualTermsHash = SHA256("Migrated proposal").toString();
+
+    // Some delay for waiting 2 blocks before each test (in order to have the previous state update reflected on the chain).
+    beforeEach((done) => setTimeout(done, 1000));
+
+    before(async () => {
+      legacyServiceAccount = await eoslimeInstance.Account.createFromName(
+        "dhslegacy",
+        eosioDefaultAccount
+      );
+
+      const randomAccounts = await eoslimeInstance.Account.createRandoms(
+        4,
+        eosioDefaultAccount
+      );
+
+      legacyDealer = randomAccounts[0];
+      legacyBidder1 = randomAccounts[1];
+      legacyBidder2 = randomAccounts[2];
+      legacyJuror = randomAccounts[3];
+    });
+
+    it("Should store the rows with the previous contract version", async () => {
+      legacyServiceContract = await eoslimeInstance.Contract.deployOnAccount(
+        DHS_SERVICE_LEGACY_WASM_PATH,
+        DHS_SERVICE_LEGACY_ABI_PATH,
+        legacyServiceAccount
+      );
+
+      // Users and juror (hex string hashes).
+      for (const user of [legacyDealer, legacyBidder1, legacyBidder2]) {
+        await legacyServiceContract.actions.signup(
+          [user.name, 0, SHA256(user.name).toString()],
+          { from: user }
+        );
+      }
+      await legacyServiceContract.actions.signup(
+        [legacyJuror.name, 1, SHA256(legacyJuror.name).toString()],
+        { from: legacyJuror }
+      );
+
+      // Request 1 stays open with two bidders (stored in the request bidders list).
+      await legacyServiceContract.actions.postrequest(
+        [legacyDealer.name, summary, contractualTermsHash, price, deadline],
+        { from: legacyDealer }
+      );
+      await legacyServiceContract.actions.propose([legacyBidder1.name, 1], {
+        from: legacyBidder1,
+      });
+      await legacyServiceContract.actions.propose([legacyBidder2.name, 1], {
+        from: legacyBidder2,
+      });
+
+      // Request 2 becomes a handshake with two proposals (stored in the negotiations row vectors).
+      await legacyServiceContract.actions.postrequest(
+        [legacyDealer.name, summary, contractualTermsHash, price, deadline],
+        { from: legacyDealer }
+      );
+      await legacyServiceContract.actions.propose([legacyBidder1.name, 2], {
+        from: legacyBidder1,
+      });
+      await legacyServiceContract.actions.selectbidder(
+        [legacyDealer.name, legacyBidder1.name, 2],
+        { from: legacyDealer }
+      );
+      await legacyServiceContract.actions.negotiate(
+        [
+          legacyBidder1.name,
+          2,
+          proposedContractualTermsHash,
+          proposedPrice,
+          proposedDeadline,
+        ],
+        { from: legacyBidder1 }
+      );
+
+      // Get table information.
+      const negotiations = await legacyServiceContract.tables.negotiations.find();
+
+      assert.equal(
+        negotiations[0].proposed_prices.length,
+        2,
+        "Incorrect legacy proposals"
+      );
+    }).timeout(20000);
+
+    it("It should not be possible to use the upgraded contract before the migration", async () => {
+      migratedServiceContract = await eoslimeInstance.Contract.deployOnAccount(
+        DHS_SERVICE_WASM_PATH,
+        DHS_SERVICE_ABI_PATH,
+        legacyServiceAccount
+      );
+
+      // Call smart contract action.
+      try {
+        await migratedServiceContract.actions.propose(
+          [legacyBidder2.name, 2],
+          { from: legacyBidder2 }
+        );
+      } catch (e) {
+        assert.isTrue(
+          e.includes(
+            "assertion failure with message: propose: MIGRATION PENDING"
+          ),
+          "Expected an exception but none was received"
+        );
+      }
+    }).timeout(10000);
+
+    it("Should it be possible to migrate the rows after the upgrade", async () => {
+      // Call smart contract action (3 users, the juror with its pool slot, then the first proposal of request 1).
+      await migratedServiceContract.actions.migratehash([6], {
+        from: legacyServiceAccount,
+      });
+
+      // The budget counts the child rows, so the migration stops between the proposals of request 1.
+      const partial = await migratedServiceContract.tables.hashmigr.find();
+      const partialProposals =
+        await migratedServiceContract.tables.proposals.find();
+
+      assert.equal(partial[0].step, 2, "Incorrect partial migration step");
+      assert.equal(partial[0].cursor, 1, "Incorrect partial migration cursor");
+      assert.equal(partial[0].child, 1, "Incorrect partial migration child");
+      assert.equal(partialProposals.length, 1, "Incorrect partial proposals");
+
+      // Call smart contract action (a small budget, so the migration resumes across the calls).
+      for (let i = 0; i < 10; i++) {
+        const migration = await migratedServiceContract.tables.hashmigr.find();
+
+        if (migration.length > 0 && migration[0].step == 5) break;
+
+        await migratedServiceContract.actions.migratehash([3], {
+          from: legacyServiceAccount,
+        });
+      }
+
+      // Get tables information.
+      const migration = await migratedServiceContract.tables.hashmigr.find();
+      const user = await migratedServiceContract.tables.users
+        .equal(legacyDealer.name)
+        .find();
+      const juror = await migratedServiceContract.tables.jurors
+        .equal(legacyJuror.name)
+        .find();
+      const requests = await migratedServiceContract.tables.requests.find();
+      const proposals = await migratedServiceContract.tables.proposals.find();
+      const handshake = await migratedServiceContract.tables.handshakes
+        .equal(2)
+        .find();
+      const rounds = await migratedServiceContract.tables.rounds.find();
+      const slots = await migratedServiceContract.tables.jurorslots.find();
+      const stats = await migratedServiceContract.tables.stats.find();
+
+      assert.equal(migration[0].step, 5, "Incorrect migration step");
+      assert.equal(
+        user[0].info.external_data_hash,
+        SHA256(legacyDealer.name).toString(),
+        "Incorrect user external data hash"
+      );
+      assert.equal(
+        juror[0].info.external_data_hash,
+        SHA256(legacyJuror.name).toString(),
+        "Incorrect juror external data hash"
+      );
+      assert.deepEqual(
+        slots.map((slot) => slot.juror),
+        [legacyJuror.name],
+        "Incorrect juror pool"
+      );
+
+      assert.equal(requests.length, 2, "Incorrect requests");
+      assert.equal(
+        requests[0].contractual_terms_hash,
+        contractualTermsHash,
+        "Incorrect request contractual terms hash"
+      );
+      assert.equal(requests[1].bidder, legacyBidder1.name, "Incorrect bidder");
+
+      // The bidders lists become proposals rows, in the order of the proposals.
+      assert.deepEqual(
+        proposals.map((proposal) => [proposal.request_id, proposal.bidder]),
+        [
+          [1, legacyBidder1.name],
+          [1, legacyBidder2.name],
+          [2, legacyBidder1.name],
+        ],
+        "Incorrect proposals"
+      );
+
+      // The negotiations row is folded into the handshake (the table is no longer in the ABI), its vectors become rounds rows.
+      assert.equal(handshake[0].rounds, 2, "Incorrect handshake rounds");
+      assert.equal(
+        handshake[0].price,
+        proposedPrice,
+        "Incorrect handshake price"
+      );
+      assert.equal(
+        handshake[0].deadline,
+        proposedDeadline,
+        "Incorrect handshake deadline"
+      );
+      assert.equal(
+        handshake[0].contractual_terms_hash,
+        proposedContractualTermsHash,
+        "Incorrect handshake contractual terms hash"
+      );
+      assert.deepEqual(
+        rounds.map((round) => [round.round, round.price, round.deadline]),
+        [
+          [0, price, deadline],
+          [1, proposedPrice, proposedDeadline],
+        ],
+        "Incorrect rounds"
+      );
+
+      assert.equal(stats[0].users, 3, "Incorrect registered users");
+      assert.equal(stats[0].jurors, 1, "Incorrect registered jurors");
+      assert.equal(stats[0].open_requests, 1, "Incorrect open requests");
+      assert.equal(stats[0].handshakes[0], 1, "Incorrect negotiations");
+    }).timeout(20000);
+
+    it("Should it be possible to update the migrated rows through their secondary indexes", async () => {
+      // Call smart contract actions (closing the request and negotiating update the migrated secondary entries).
+      await migratedServiceContract.actions.selectbidder(
+        [legacyDealer.name, legacyBidder2.name, 1],
+        { from: legacyDealer }
+      );
+      await migratedServiceContract.actions.negotiate(
+        [legacyDealer.name, 2, newContractualTermsHash, newPrice, deadline],
+        { from: legacyDealer }
+      );
+
+      // Get tables information.
+      const request = await migratedServiceContract.tables.requests
+        .equal(1)
+        .find();
+      const handshake = await migratedServiceContract.tables.handshakes
+        .equal(2)
+        .find();
+      const round = await migratedServiceContract.tables.rounds
+        .equal(roundKey(2, 2))
+        .find();
+
+      assert.equal(request[0].status, 1, "Incorrect request status");
+      assert.equal(request[0].bidder, legacyBidder2.name, "Incorrect bidder");
+      assert.equal(handshake[0].rounds, 3, "Incorrect handshake rounds");
+      assert.equal(handshake[0].price, newPrice, "Incorrect handshake price");
+      assert.equal(round[0].price, newPrice, "Incorrect round price");
+    }).timeout(10000);
+  }).timeout(5000);
+
+  describe("# Escrow Lock Migration", () => {
+    // Contract running the previous dhsescrow contract version, upgraded again to the current one by the tests.
+    let legacyEscrowContract: Contract;
+
+    // Users of the handshake locked with the previous escrow version.
+    let lockDealer: Account;
+    let lockBidder: Account;
+    let leftoverUser: Account;
+    let id: number;
+
+    const price = "10.0000 DHS";
+    const deadline = Math.floor(Date.now() * 0.001) + 30 * 24 * 3600;
+
+    // Some delay for waiting 2 blocks before each test (in order to have the previous state update reflected on the chain).
+    beforeEach((done) => setTimeout(done, 1000));
+
+    before(async () => {
+      const randomAccounts = await eoslimeInstance.Account.createRandoms(
+        3,
+        eosioDefaultAccount
+      );
+
+      lockDealer = randomAccounts[0];
+      lockBidder = randomAccounts[1];
+      leftoverUser = randomAccounts[2];
+
+      // Users registration.
+      for (const user of [lockDealer, lockBidder]) {
+        await dhsServiceContract.actions.signup(
+          [user.name, 0, SHA256(user.name).toString()],
+          { from: user }
+        );
+        await dhsTokenContract.actions.transfer(
+          [
+            dhsTokenAccount.name,
+            user.name,
+            WELCOME_BONUS_USER,
+            "Welcome Bonus",
+          ],
+          { from: dhsTokenAccount }
+        );
+      }
+
+      // Handshake waiting for the locks.
+      await dhsServiceContract.actions.postrequest(
+        [
+          lockDealer.name,
+          "Locked with the previous escrow",
+          SHA256("Legacy escrow terms").toString(),
+          price,
+          deadline,
+        ],
+        { from: lockDealer }
+      );
+
+      id = (await requestCounterTable.find())[0].last_id;
+
+      await dhsServiceContract.actions.propose([lockBidder.name, id], {
+        from: lockBidder,
+      });
+      await dhsServiceContract.actions.selectbidder(
+        [lockDealer.name, lockBidder.name, id],
+        { from: lockDealer }
+      );
+      await dhsServiceContract.actions.acceptterms([lockBidder.name, id], {
+        from: lockBidder,
+      });
+      await dhsServiceContract.actions.acceptterms([lockDealer.name, id], {
+        from: lockDealer,
+      });
+    });
+
+    it("Should store the locked balances with the previous escrow version", async () => {
+      legacyEscrowContract = await eoslimeInstance.Contract.deployOnAccount(
+        DHS_ESCROW_LEGACY_WASM_PATH,
+        DHS_ESCROW_LEGACY_ABI_PATH,
+        dhsEscrowAccount
+      );
+
+      // The previous escrow version tracked the forwarded tokens per user, through `locktokens`.
+      await dhsTokenContract.actions.transfer(
+        [lockDealer.name, dhsServiceAccount.name, "40.0000 DHS", id.toString()],
+        { from: lockDealer }
+      );
+      await legacyEscrowContract.actions.locktokens(
+        [dhsServiceAccount.name, lockDealer.name, "40.0000 DHS"],
+        { from: dhsServiceAccount }
+      );
+      await dhsTokenContract.actions.transfer(
+        [lockBidder.name, dhsServiceAccount.name, "30.0000 DHS", id.toString()],
+        { from: lockBidder }
+      );
+      await legacyEscrowContract.actions.locktokens(
+        [dhsServiceAccount.name, lockBidder.name, "30.0000 DHS"],
+        { from: dhsServiceAccount }
+      );
+
+      // A balance backing no handshake.
+      await dhsTokenContract.actions.transfer(
+        [dhsTokenAccount.name, dhsEscrowAccount.name, "5.0000 DHS", "Leftover"],
+        { from: dhsTokenAccount }
+      );
+      await legacyEscrowContract.actions.locktokens(
+        [dhsServiceAccount.name, leftoverUser.name, "5.0000 DHS"],
+        { from: dhsServiceAccount }
+      );
+
+      // Get tables information.
+      const locked = await legacyEscrowContract.tables.locked.find();
+      const handshake = await handshakesTable.equal(id).find();
+
+      assert.equal(locked.length, 3, "Incorrect legacy locked balances");
+      assert.equal(handshake[0].status, 2, "Incorrect handshake status");
+    }).timeout(20000);
+
+    it("It should not be possible to settle a handshake before the locks migration", async () => {
+      dhsEscrowContract = await eoslimeInstance.Contract.deployOnAccount(
+        DHS_ESCROW_WASM_PATH,
+        DHS_ESCROW_ABI_PATH,
+        dhsEscrowAccount
+      );
+
+      await dhsServiceContract.actions.endjob([lockBidder.name, id], {
+        from: lockBidder,
+      });
+
+      // Call smart contract action (the inline settlement fails on the legacy balances).
+      try {
+        await dhsServiceContract.actions.acceptjob([lockDealer.name, id], {
+          from: lockDealer,
+        });
+      } catch (e) {
+        assert.isTrue(
+          e.includes(
+            "assertion failure with message: accepted: MIGRATION PENDING"
+          ),
+          "Expected an exception but none was received"
+        );
+      }
+    }).timeout(10000);
+
+    it("It should not be possible to migrate the locks given zero max rows", async () => {
+      // Call smart contract action.
+      try {
+        await dhsEscrowContract.actions.migratelocks([0], {
+          from: unregisteredUser,
+        });
+      } catch (e) {
+        assert.isTrue(
+          e.includes(
+            "assertion failure with message: migratelocks: INVALID MAX ROWS"
+          ),
+          "Expected an exception but none was received"
+        );
+      }
+    }).timeout(3000);
+
+    it("Should it be possible to migrate the legacy locks into the ledger", async () => {
+      const statsBefore = await escrowStatsTable.find();
+
+      // Call smart contract action (a small budget, so the migration resumes across the calls).
+      for (let i = 0; i < 20; i++) {
+        try {
+          await dhsEscrowContract.actions.migratelocks([10], {
+            from: unregisteredUser,
+          });
+        } catch (e) {
+          assert.isTrue(
+            e.includes(
+              "assertion failure with message: migratelocks: NO LEGACY LOCKS"
+            ),
+            "Incorrect migration failure"
+          );
+          break;
+        }
+      }
+
+      // Get tables information.
+      const lockedBalance = await lockedBalanceTable.equal(id).find();
+      const escrowStats = await escrowStatsTable.find();
+      const migration = await dhsEscrowContract.tables.lockmigr.find();
+      const leftoverBalance = await leftoverUser.getBalance(
+        "DHS",
+        dhsTokenContract.name
+      );
+      const lockedAmount = (asset: string) => parseFloat(asset.split(" ")[0]);
+
+      assert.equal(
+        lockedBalance[0].dealer,
+        lockDealer.name,
+        "Incorrect dealer"
+      );
+      assert.equal(
+        lockedBalance[0].bidder,
+        lockBidder.name,
+        "Incorrect bidder"
+      );
+      assert.equal(
+        lockedBalance[0].dealer_funds,
+        "40.0000 DHS",
+        "Incorrect dealer funds"
+      );
+      assert.equal(
+        lockedBalance[0].bidder_funds,
+        "30.0000 DHS",
+        "Incorrect bidder funds"
+      );
+      assert.equal(
+        lockedAmount(escrowStats[0].total_locked),
+        lockedAmount(statsBefore[0].total_locked) + 70,
+        "Incorrect escrow total locked"
+      );
+      assert.equal(
+        escrowStats[0].open_locks,
+        statsBefore[0].open_locks + 1,
+        "Incorrect escrow open locks"
+      );
+      assert.equal(migration.length, 0, "Incorrect migration progress");
+      assert.equal(leftoverBalance[0], "5.0000 DHS", "Incorrect refund");
+    }).timeout(30000);
+
+    it("Should it be possible to settle a migrated handshake", async () => {
+      // Call smart contract action.
+      await dhsServiceContract.actions.acceptjob([lockDealer.name, id], {
+        from: lockDealer,
+      });
+
+      // Get tables information.
+      const lockedBalance = await lockedBalanceTable.equal(id).find();
+      const dealerBalance = await lockDealer.getBalance(
+        "DHS",
+        dhsTokenContract.name
+      );
+      const bidderBalance = await lockBidder.getBalance(
+        "DHS",
+        dhsTokenContract.name
+      );
+
+      assert.equal(lockedBalance.length, 0, "Incorrect escrow ledger");
+      assert.equal(
+        dealerBalance[0],
+        "990.0000 DHS",
+        "Incorrect dealer balance"
+      );
+      assert.equal(
+        bidderBalance[0],
+        "1010.0000 DHS",
+        "Incorrect bidder balance"
+      );
+    }).timeout(10000);
   }).timeout(5000);
 });